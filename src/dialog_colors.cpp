@@ -35,6 +35,7 @@ Dialog_Colors::Dialog_Colors(MainWindow *parent)
    m_syntaxFname  = m_struSettings.pathSyntax + "syn_cpp.json";  
 
    m_syntaxParser = new Syntax(m_ui->sample->document(), m_syntaxFname, m_struSettings);
+   m_syntaxParser->set_SyntaxType(SYN_C);
    updateParser(false);
 
    //
@@ -0,0 +1,171 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#include "dialog_profile.h"
+#include "util.h"
+
+#include <QFile>
+#include <QFileDialog>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+Dialog_Profile::Dialog_Profile(Syntax *parser)
+   : m_ui(new Ui::Dialog_Profile)
+{
+   m_ui->setupUi(this);
+   this->setWindowIcon(QIcon("://resources/diamond.png"));
+
+   m_parser = parser;
+
+   m_model = new QStandardItemModel(this);
+   m_model->setColumnCount(7);
+   m_model->setHeaderData(0, Qt::Horizontal, tr("File"));
+   m_model->setHeaderData(1, Qt::Horizontal, tr("Rules"));
+   m_model->setHeaderData(2, Qt::Horizontal, tr("Calls"));
+   m_model->setHeaderData(3, Qt::Horizontal, tr("Hits"));
+   m_model->setHeaderData(4, Qt::Horizontal, tr("Total ms"));
+   m_model->setHeaderData(5, Qt::Horizontal, tr("Worst Block ms"));
+   m_model->setHeaderData(6, Qt::Horizontal, tr("Warning"));
+
+   m_ui->profileTable->setModel(m_model);
+   m_ui->profileTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+   m_ui->profileTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+   m_ui->profileTable->setSortingEnabled(true);
+   m_ui->profileTable->horizontalHeader()->setStretchLastSection(true);
+   m_ui->profileTable->verticalHeader()->hide();
+
+   m_ui->enable_CB->setChecked(SyntaxDefinition::isProfiling());
+   m_ui->rehighlight_PB->setEnabled(m_parser != nullptr);
+
+   connect(m_ui->enable_CB,      &QCheckBox::toggled,    this, &Dialog_Profile::enableProfile);
+   connect(m_ui->rehighlight_PB, &QPushButton::clicked,  this, &Dialog_Profile::rehighlight);
+   connect(m_ui->refresh_PB,     &QPushButton::clicked,  this, &Dialog_Profile::refresh);
+   connect(m_ui->reset_PB,       &QPushButton::clicked,  this, &Dialog_Profile::reset);
+   connect(m_ui->export_PB,      &QPushButton::clicked,  this, &Dialog_Profile::exportReport);
+   connect(m_ui->close_PB,       &QPushButton::clicked,  this, &Dialog_Profile::cancel);
+
+   refresh();
+}
+
+Dialog_Profile::~Dialog_Profile()
+{
+   delete m_ui;
+}
+
+void Dialog_Profile::enableProfile(bool checked)
+{
+   SyntaxDefinition::setProfiling(checked);
+}
+
+void Dialog_Profile::rehighlight()
+{
+   // tokenize the current tab again so every block is measured
+   if (! m_ui->enable_CB->isChecked()) {
+      m_ui->enable_CB->setChecked(true);
+   }
+
+   m_parser->forceTokenize();
+}
+
+void Dialog_Profile::refresh()
+{
+   m_report = SyntaxDefinition::profileReport();
+
+   m_model->removeRows(0, m_model->rowCount());
+   m_ui->profileTable->setSortingEnabled(false);
+
+   int row = 0;
+
+   for (const auto &value : m_report) {
+      QJsonObject object = value.toObject();
+
+      QStringList patternList;
+      QStringList warningList;
+
+      for (const auto &rule : object.value("rules").toArray()) {
+         QJsonObject ruleObject = rule.toObject();
+
+         patternList.append(ruleObject.value("pattern").toString());
+
+         if (ruleObject.contains("warning")) {
+            warningList.append(ruleObject.value("warning").toString());
+         }
+      }
+
+      QStandardItem *calls = new QStandardItem;
+      calls->setData(object.value("calls").toDouble(), Qt::DisplayRole);
+
+      QStandardItem *hits = new QStandardItem;
+      hits->setData(object.value("hits").toDouble(), Qt::DisplayRole);
+
+      QStandardItem *total = new QStandardItem;
+      total->setData(object.value("total-ms").toDouble(), Qt::DisplayRole);
+
+      QStandardItem *worst = new QStandardItem;
+      worst->setData(object.value("worst-block-ms").toDouble(), Qt::DisplayRole);
+
+      m_model->setItem(row, 0, new QStandardItem(object.value("file").toString()));
+      m_model->setItem(row, 1, new QStandardItem(patternList.join("  |  ")));
+      m_model->setItem(row, 2, calls);
+      m_model->setItem(row, 3, hits);
+      m_model->setItem(row, 4, total);
+      m_model->setItem(row, 5, worst);
+      m_model->setItem(row, 6, new QStandardItem(warningList.join("; ")));
+
+      ++row;
+   }
+
+   m_ui->profileTable->setSortingEnabled(true);
+   m_ui->profileTable->sortByColumn(4, Qt::DescendingOrder);
+   m_ui->profileTable->resizeColumnsToContents();
+}
+
+void Dialog_Profile::reset()
+{
+   SyntaxDefinition::resetProfile();
+   refresh();
+}
+
+void Dialog_Profile::exportReport()
+{
+   QString selectedFilter;
+   QFileDialog::Options options;
+
+   // force windows 7 and 8 to honor initial path
+   options = QFileDialog::ForceInitialDir_Win7;
+
+   QString fileName = QFileDialog::getSaveFileName(this, tr("Export Syntax Profile"),
+         "syntax_profile.json", tr("Json Files (*.json)"), &selectedFilter, options);
+
+   if (fileName.isEmpty()) {
+      return;
+   }
+
+   QFile file(fileName);
+
+   if (! file.open(QFile::WriteOnly | QFile::Truncate)) {
+      const QString msg = tr("Unable to save file: ") +  fileName + " : " + file.errorString();
+      csError(tr("Export Syntax Profile"), msg);
+      return;
+   }
+
+   file.write(QJsonDocument(m_report).toJson());
+   file.close();
+}
+
+void Dialog_Profile::cancel()
+{
+   this->done(QDialog::Rejected);
+}
@@ -0,0 +1,48 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#ifndef DIALOG_PROFILE_H
+#define DIALOG_PROFILE_H
+
+#include "ui_dialog_profile.h"
+#include "syntax.h"
+
+#include <QDialog>
+#include <QJsonArray>
+#include <QStandardItemModel>
+
+class Dialog_Profile : public QDialog
+{
+   CS_OBJECT(Dialog_Profile)
+
+   public:
+      Dialog_Profile(Syntax *parser);
+      ~Dialog_Profile();
+
+   private:
+      Ui::Dialog_Profile *m_ui;
+      Syntax *m_parser;
+
+      QStandardItemModel *m_model;
+      QJsonArray m_report;
+
+      void enableProfile(bool checked);
+      void rehighlight();
+      void refresh();
+      void reset();
+      void exportReport();
+      void cancel();
+};
+
+#endif
@@ -17,11 +17,17 @@
 
 #include <QApplication>
 #include <QClipboard>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QPainter>
 #include <QShortcutEvent>
+#include <QTimer>
 
 const QColor FILL_COLOR = QColor(0xD0D0D0);
 
+// milliseconds the context menu waits for spelling suggestions
+static const int SUGGEST_TIMEOUT = 3000;
+
 DiamondTextEdit::DiamondTextEdit(MainWindow *from, struct Settings settings, SpellCheck *spell, QString owner)
       : QPlainTextEdit()
 {
@@ -44,11 +50,17 @@ DiamondTextEdit::DiamondTextEdit(MainWindow *from, struct Settings settings, Spe
    // syntax - assinged from loadfile(), runSyntax()
    m_synFName     = "";
    m_syntaxParser = 0;
+   m_syntaxMode   = SYNTAX_AUTO;
 
    // spell check
    m_spellCheck   = spell;
    m_isSpellCheck = settings.isSpellCheck;
 
+   // tab memory
+   m_isStub       = false;
+   m_stubPosition = 0;
+   m_lastUsed     = QDateTime::currentMSecsSinceEpoch();
+
    // line highlight bar
    connect(this, &DiamondTextEdit::blockCountChanged, this, &DiamondTextEdit::update_LineNumWidth);
    connect(this, &DiamondTextEdit::updateRequest,     this, &DiamondTextEdit::update_LineNumArea);
@@ -116,6 +128,8 @@ void DiamondTextEdit::update_LineNumArea(const QRect &rect, int dy)
    if (rect.contains(viewport()->rect())) {
       update_LineNumWidth(0);
    }
+
+   update_SyntaxView();
 }
 
 void DiamondTextEdit::resizeEvent(QResizeEvent *e)
@@ -170,13 +184,52 @@ void DiamondTextEdit::contextMenuEvent(QContextMenuEvent *event)
       // set up to save words, used in add_userDict() and replaceWord()
       m_cursor = cursor;
 
-      QStringList m_maybeList = m_mainWindow->spell_getMaybe(selectedText);
-      int cnt = m_maybeList.count();
+      if (! selectedText.isEmpty() && ! m_spellCheck->spell(selectedText)) {
+         QStringList maybeList;
+
+         if (m_spellCheck->suggestCached(selectedText, maybeList)) {
+
+            for (const QString &item : maybeList)  {
+               menu->addAction(item, m_mainWindow, SLOT(spell_replaceWord())  );
+            }
+
+         } else {
+            // hunspell can take a while, the menu opens now and the suggestions are added when ready
+            QAction *waitAction = menu->addAction("Looking up suggestions...");
+            waitAction->setDisabled(true);
 
-      if (cnt > 0)  {
+            QElapsedTimer elapsed;
+            elapsed.start();
 
-         for (int k = 0; k < cnt; ++k)  {
-            menu->addAction(m_maybeList[k], m_mainWindow, SLOT(spell_replaceWord())  );
+            QTimer *timer = new QTimer(menu);
+
+            connect(timer, &QTimer::timeout, menu, [this, menu, timer, waitAction, selectedText, elapsed] () {
+               QStringList list;
+
+               if (m_spellCheck->suggestCached(selectedText, list)) {
+                  timer->stop();
+
+                  for (const QString &item : list)  {
+                     QAction *action = menu->addAction(item, m_mainWindow, SLOT(spell_replaceWord())  );
+
+                     menu->removeAction(action);
+                     menu->insertAction(waitAction, action);
+                  }
+
+                  if (list.isEmpty()) {
+                     waitAction->setText("No Suggestions");
+                  } else {
+                     menu->removeAction(waitAction);
+                  }
+
+               } else if (elapsed.elapsed() > SUGGEST_TIMEOUT) {
+                  // still cached when it finishes, the next right click shows it
+                  timer->stop();
+                  waitAction->setText("No Suggestions");
+               }
+            } );
+
+            timer->start(25);
          }
 
          menu->addAction("Add to User Dictionary", m_mainWindow, SLOT(spell_addUserDict()) );
@@ -256,6 +309,31 @@ Syntax * DiamondTextEdit::get_SyntaxParser()
 void DiamondTextEdit::set_SyntaxParser(Syntax *parser)
 {
    m_syntaxParser = parser;
+   update_SyntaxView();
+}
+
+void DiamondTextEdit::update_SyntaxView()
+{
+   // tell the parser which blocks are on screen so they are highlighted first
+   if (! m_syntaxParser) {
+      return;
+   }
+
+   QTextBlock block = firstVisibleBlock();
+
+   int first  = block.blockNumber();
+   int last   = first;
+   int top    = (int) blockBoundingGeometry(block).translated(contentOffset()).top();
+   int height = viewport()->height();
+
+   while (block.isValid() && top <= height) {
+      last = block.blockNumber();
+      top += (int) blockBoundingRect(block).height();
+
+      block = block.next();
+   }
+
+   m_syntaxParser->setVisibleBlocks(first, last);
 }
 
 SyntaxTypes DiamondTextEdit::get_SyntaxEnum()
@@ -268,6 +346,50 @@ void DiamondTextEdit::set_SyntaxEnum(SyntaxTypes data)
    m_syntaxEnum = data;
 }
 
+SyntaxMode DiamondTextEdit::get_SyntaxMode()
+{
+   return m_syntaxMode;
+}
+
+void DiamondTextEdit::set_SyntaxMode(SyntaxMode data)
+{
+   // per tab override of the large file policy
+   m_syntaxMode = data;
+}
+
+
+// ** tab memory
+bool DiamondTextEdit::get_IsStub()
+{
+   return m_isStub;
+}
+
+void DiamondTextEdit::set_IsStub(bool data)
+{
+   m_isStub = data;
+}
+
+int DiamondTextEdit::get_StubPosition()
+{
+   return m_stubPosition;
+}
+
+void DiamondTextEdit::set_StubPosition(int data)
+{
+   // cursor position when the text was unloaded
+   m_stubPosition = data;
+}
+
+qint64 DiamondTextEdit::get_LastUsed()
+{
+   return m_lastUsed;
+}
+
+void DiamondTextEdit::set_LastUsed(qint64 data)
+{
+   m_lastUsed = data;
+}
+
 
 // ** spell check
 void DiamondTextEdit::set_Spell(bool value)
@@ -68,6 +68,16 @@ class DiamondTextEdit : public QPlainTextEdit
       void set_SyntaxParser(Syntax *data);
       SyntaxTypes get_SyntaxEnum();
       void set_SyntaxEnum(SyntaxTypes data);
+      SyntaxMode get_SyntaxMode();
+      void set_SyntaxMode(SyntaxMode data);
+
+      // tab memory, a stub holds no text until the tab is shown
+      bool get_IsStub();
+      void set_IsStub(bool data);
+      int get_StubPosition();
+      void set_StubPosition(int data);
+      qint64 get_LastUsed();
+      void set_LastUsed(qint64 data);
 
       CS_SLOT_1(Public, void cut())
       CS_SLOT_2(cut)
@@ -95,6 +105,9 @@ class DiamondTextEdit : public QPlainTextEdit
       int m_undoCount;
       void removeColumnModeSpaces();
 
+      // syntax
+      void update_SyntaxView();
+
       bool m_showlineNum;
       bool m_colHighlight;
 
@@ -120,6 +133,12 @@ class DiamondTextEdit : public QPlainTextEdit
       Syntax *m_syntaxParser;
       QString m_synFName;
       SyntaxTypes m_syntaxEnum;
+      SyntaxMode m_syntaxMode;
+
+      // tab memory
+      bool m_isStub;
+      int m_stubPosition;
+      qint64 m_lastUsed;
 
       CS_SLOT_1(Private, void update_LineNumWidth(int newBlockCount))
       CS_SLOT_2(update_LineNumWidth) 
@@ -0,0 +1,210 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#include "file_loader.h"
+
+#include <cstring>
+
+#include <QByteArray>
+#include <QFile>
+#include <QTextCodec>
+
+// bytes read at a time, also the largest piece inserted into the document at once
+static const qint64 WORKER_CHUNK_SIZE = 1024 * 1024;
+
+// pieces decoded ahead of the document
+static const int MAX_QUEUED = 8;
+
+LoadDecoder::LoadDecoder()
+   : m_decoder(QTextCodec::codecForName("UTF-8"))
+{
+   m_isPendingCR = false;
+}
+
+QString LoadDecoder::decode(char *data, qint64 size)
+{
+   QString retval;
+
+   if (size <= 0) {
+      return retval;
+   }
+
+   if (m_isPendingCR && data[0] != '\n') {
+      retval = "\r";
+   }
+
+   m_isPendingCR = (data[size - 1] == '\r');
+
+   if (m_isPendingCR) {
+      --size;
+   }
+
+   // remove the carriage return of each pair
+   if (std::memchr(data, '\r', size) != nullptr) {
+      qint64 count = 0;
+
+      for (qint64 k = 0; k < size; ++k) {
+         if (data[k] == '\r' && k + 1 < size && data[k + 1] == '\n') {
+            continue;
+         }
+
+         data[count] = data[k];
+         ++count;
+      }
+
+      size = count;
+   }
+
+   retval += m_decoder.toUnicode(data, size);
+
+   return retval;
+}
+
+QString LoadDecoder::finish()
+{
+   QString retval;
+
+   if (m_isPendingCR) {
+      retval = "\r";
+      m_isPendingCR = false;
+   }
+
+   return retval;
+}
+
+FileLoader::FileLoader(const QString &fileName, qint64 fileSize)
+   : m_fileName(fileName), m_fileSize(fileSize)
+{
+   m_bytesRead   = 0;
+   m_isFinished  = false;
+   m_isCancelled = false;
+}
+
+FileLoader::~FileLoader()
+{
+   cancel();
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+}
+
+void FileLoader::start()
+{
+   m_thread = std::thread(&FileLoader::run, this);
+}
+
+void FileLoader::cancel()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isCancelled = true;
+   }
+
+   m_condition.notify_one();
+}
+
+bool FileLoader::takeText(QString &text)
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_textList.empty()) {
+         return false;
+      }
+
+      text = std::move(m_textList.front());
+      m_textList.pop_front();
+   }
+
+   m_condition.notify_one();
+
+   return true;
+}
+
+bool FileLoader::isDone()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_isFinished && m_textList.empty();
+}
+
+QString FileLoader::errorString()
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+   return m_error;
+}
+
+qint64 FileLoader::bytesRead() const
+{
+   return m_bytesRead;
+}
+
+qint64 FileLoader::fileSize() const
+{
+   return m_fileSize;
+}
+
+void FileLoader::run()
+{
+   QFile file(m_fileName);
+   QString error;
+
+   if (file.open(QFile::ReadOnly)) {
+      LoadDecoder decoder;
+
+      QByteArray buffer;
+      buffer.resize(WORKER_CHUNK_SIZE);
+
+      while (true) {
+         {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_condition.wait(lock, [this] ()
+                  { return m_isCancelled || static_cast<int>(m_textList.size()) < MAX_QUEUED; } );
+
+            if (m_isCancelled) {
+               break;
+            }
+         }
+
+         qint64 size = file.read(buffer.data(), WORKER_CHUNK_SIZE);
+
+         if (size < 0) {
+            error = file.errorString();
+            break;
+         }
+
+         QString text = (size == 0) ? decoder.finish() : decoder.decode(buffer.data(), size);
+         m_bytesRead += size;
+
+         if (! text.isEmpty()) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_textList.push_back(std::move(text));
+         }
+
+         if (size == 0) {
+            break;
+         }
+      }
+
+   } else {
+      error = file.errorString();
+
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   m_error      = error;
+   m_isFinished = true;
+}
@@ -0,0 +1,88 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#ifndef FILE_LOADER_H
+#define FILE_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <QString>
+#include <QTextDecoder>
+
+// decodes a file one chunk at a time, a character or line break split across two chunks is
+// completed by the next call, line breaks are stored as a single new line
+class LoadDecoder
+{
+   public:
+      LoadDecoder();
+
+      // data is modified in place
+      QString decode(char *data, qint64 size);
+      QString finish();
+
+   private:
+      QTextDecoder m_decoder;
+
+      // carriage return at the end of the previous chunk
+      bool m_isPendingCR;
+};
+
+// reads and decodes a file on a worker thread, the text is taken by the GUI thread in pieces
+class FileLoader
+{
+   public:
+      FileLoader(const QString &fileName, qint64 fileSize);
+      ~FileLoader();
+
+      void start();
+      void cancel();
+
+      // returns false when no text is ready
+      bool takeText(QString &text);
+
+      // every piece has been taken
+      bool isDone();
+
+      // valid once done
+      QString errorString();
+
+      qint64 bytesRead() const;
+      qint64 fileSize() const;
+
+   private:
+      QString m_fileName;
+      qint64 m_fileSize;
+
+      std::atomic<qint64> m_bytesRead;
+
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
+
+      // bounded so a slow document does not hold the whole file in memory
+      std::deque<QString> m_textList;
+
+      QString m_error;
+      bool m_isFinished;
+      bool m_isCancelled;
+
+      std::thread m_thread;
+
+      void run();
+};
+
+#endif
@@ -95,6 +95,52 @@ bool MainWindow::json_Read(Config trail)
       value = object.value("rewrapColumn");
       m_struct.rewrapColumn = value.toInt();
 
+      value = object.value("syntax-slice-ms");
+      m_struct.syntaxSliceBudget = value.toInt();
+
+      if (m_struct.syntaxSliceBudget <= 0) {
+         m_struct.syntaxSliceBudget = 20;
+      }
+
+      // large file policy, the size is in millions of characters which is about MB for plain text
+      m_struct.largeFileSize   = object.value("large-file-size").toInt();
+      m_struct.largeLineLength = object.value("large-line-length").toInt();
+
+      if (m_struct.largeFileSize <= 0) {
+         m_struct.largeFileSize = 20;
+
+      } else if (m_struct.largeFileSize > 100000) {
+         m_struct.largeFileSize = 100000;
+
+      }
+
+      if (m_struct.largeLineLength <= 0) {
+         m_struct.largeLineLength = 5000;
+      }
+
+      // tab memory
+      m_struct.tabLazyLoad      = true;
+      m_struct.tabUnloadMinutes = 120;
+      m_struct.tabMemoryCap     = 1024;
+
+      if (object.contains("tab-lazy-load")) {
+         m_struct.tabLazyLoad = object.value("tab-lazy-load").toBool();
+      }
+
+      if (object.contains("tab-unload-minutes")) {
+         m_struct.tabUnloadMinutes = object.value("tab-unload-minutes").toInt();
+      }
+
+      if (object.contains("tab-memory-cap")) {
+         m_struct.tabMemoryCap = object.value("tab-memory-cap").toInt();
+      }
+
+      if (object.value("large-file-mode").toString() == "none") {
+         m_struct.largeFileMode = SYNTAX_NONE;
+      } else {
+         m_struct.largeFileMode = SYNTAX_KEYWORDS;
+      }
+
       m_struct.showLineHighlight = object.value("showLineHighlight").toBool();
       m_struct.showLineNumbers   = object.value("showLineNumbers").toBool();
       m_struct.isWordWrap        = object.value("word-wrap").toBool();
@@ -815,6 +861,15 @@ bool MainWindow::json_CreateNew()
    object.insert("size-height",  600);
 
    object.insert("rewrapColumn", 120);
+   object.insert("syntax-slice-ms", 20);
+
+   object.insert("large-file-size",   20);
+   object.insert("large-line-length", 5000);
+   object.insert("large-file-mode",   "keywords");
+
+   object.insert("tab-lazy-load",      true);
+   object.insert("tab-unload-minutes", 120);
+   object.insert("tab-memory-cap",     1024);
 
    object.insert("useSpaces",    true);
    object.insert("tabSpacing",   4);
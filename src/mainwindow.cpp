@@ -17,6 +17,7 @@
 
 #include <stdexcept>
 
+#include <QDateTime>
 #include <QFileInfo>
 #include <QKeySequence>
 #include <QLabel>
@@ -37,6 +38,9 @@ MainWindow::MainWindow(QStringList fileList, QStringList flagList)
       throw std::runtime_error("abort_no_message");
    }
 
+   // compiled syntax files are kept next to the config file
+   SyntaxDefinition::setCacheFile(pathName(m_jsonFname) + "/syntax.cache");
+
    // drag & drop
    setAcceptDrops(true);
 
@@ -62,6 +66,22 @@ MainWindow::MainWindow(QStringList fileList, QStringList flagList)
    // macros
    m_record = false;
 
+   // files opened in the background
+   m_loadTimer = new QTimer(this);
+   m_loadTimer->setInterval(10);
+
+   connect(m_loadTimer, &QTimer::timeout, this, &MainWindow::loadFile_Slice);
+
+   // tab memory, checked once a minute
+   m_tabMemoryTimer = new QTimer(this);
+   m_tabMemoryTimer->setInterval(60 * 1000);
+
+   connect(m_tabMemoryTimer, &QTimer::timeout, this, &MainWindow::tab_CheckMemory);
+
+   if (m_struct.tabUnloadMinutes > 0 || m_struct.tabMemoryCap > 0) {
+      m_tabMemoryTimer->start();
+   }
+
    // copy buffer
    m_actionCopyBuffer = new QShortcut(this);
    connect(m_actionCopyBuffer, &QShortcut::activated, this, &MainWindow::showCopyBuffer);
@@ -98,6 +118,9 @@ MainWindow::MainWindow(QStringList fileList, QStringList flagList)
    m_ui->menuWindow->setContextMenuPolicy(Qt::CustomContextMenu);
    connect(m_ui->menuWindow, &QMenu::customContextMenuRequested, this, &MainWindow::showContext_Tabs);
 
+   // syntax mode, context menu
+   connect(m_statusSyntax, &QLabel::customContextMenuRequested,  this, &MainWindow::showContext_SyntaxMode);
+
    // set flags after reading config and before autoload
    if (flagList.contains("--no_autoload", Qt::CaseInsensitive)) {
       m_args.flag_noAutoLoad = true;
@@ -187,6 +210,10 @@ void MainWindow::tabClose(int index)
       m_textEdit = t_textEdit;
       m_curFile  = this->get_curFileName(index);
 
+      // a partly loaded file has nothing to save
+      loadFile_Stop(t_textEdit);
+      m_syntaxPending.remove(t_textEdit);
+
       if (close_Doc()) {
 
          if ( m_tabWidget->count() > 1 ) {
@@ -217,9 +244,21 @@ void MainWindow::tabChanged(int index)
       m_curFile = this->get_curFileName(index);
       this->setCurrentTitle(m_curFile, true);
 
+      m_textEdit->set_LastUsed(QDateTime::currentMSecsSinceEpoch());
+
+      if (m_textEdit->get_IsStub()) {
+         // not read yet or unloaded while idle
+         tab_Load(m_textEdit, m_curFile);
+      }
+
       // ** retrieve slected syntax type
       m_syntaxParser = m_textEdit->get_SyntaxParser();
 
+      if (m_syntaxPending.remove(textEdit)) {
+         // opened in a batch, highlighting starts when the tab is first shown
+         setSyntax();
+      }
+
       // retrieve the menu enum
       m_syntaxEnum = m_textEdit->get_SyntaxEnum();
 
@@ -228,6 +267,7 @@ void MainWindow::tabChanged(int index)
 
       // **
       setStatus_LineCol();
+      setStatus_SyntaxMode();
       m_textEdit->set_ColumnMode(m_struct.isColumnMode);
       m_textEdit->set_ShowLineNum(m_struct.showLineNumbers);
 
@@ -477,6 +517,10 @@ void MainWindow::createConnections()
    connect(m_ui->actionMacro_Load,        &QAction::triggered, this, &MainWindow::macroLoad);
    connect(m_ui->actionMacro_EditNames,   &QAction::triggered, this, &MainWindow::macroEditNames);
    connect(m_ui->actionSpell_Check,       &QAction::triggered, this, &MainWindow::spellCheck);
+   connect(m_ui->actionSpell_Document,    &QAction::triggered, this, &MainWindow::spell_Document);
+   connect(m_ui->actionSpell_AllTabs,     &QAction::triggered, this, &MainWindow::spell_AllTabs);
+   connect(m_ui->actionSpell_Import,      &QAction::triggered, this, &MainWindow::spell_Import);
+   connect(m_ui->actionSyntax_Profile,    &QAction::triggered, this, &MainWindow::syntaxProfile);
 
    // settings
    connect(m_ui->actionColors,            &QAction::triggered, this, &MainWindow::setColors);
@@ -813,11 +857,16 @@ void MainWindow::createStatusBar()
    m_statusMode = new QLabel("", this);
    //m_statusMode->setFrameStyle(QFrame::Panel | QFrame::Sunken);
 
+   m_statusSyntax = new QLabel("", this);
+   m_statusSyntax->setToolTip(tr("Right click to change the highlighting for this tab"));
+   m_statusSyntax->setContextMenuPolicy(Qt::CustomContextMenu);
+
    m_statusName = new QLabel("", this);
    //m_statusName->setFrameStyle(QFrame::Panel | QFrame::Sunken);
 
    statusBar()->addPermanentWidget(m_statusLine, 0);
    statusBar()->addPermanentWidget(m_statusMode, 0);
+   statusBar()->addPermanentWidget(m_statusSyntax, 0);
    statusBar()->addPermanentWidget(m_statusName, 0);
 }
 
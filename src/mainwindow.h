@@ -34,6 +34,7 @@
 #include <QPushButton>
 #include <QPrinter>
 #include <QRectF>
+#include <QSet>
 #include <QShortcut>
 #include <QStandardItemModel>
 #include <QStandardPaths>
@@ -41,8 +42,13 @@
 #include <QStringList>
 #include <QSplitter>
 #include <QStackedWidget>
+#include <QTimer>
 
 class Dialog_AdvFind;
+class FileLoader;
+class QProgressBar;
+class QProgressDialog;
+class SpellReport;
 
 static const int MACRO_MAX           = 10;
 static const int OPENTABS_MAX        = 20;
@@ -64,6 +70,20 @@ struct advFindStruct
    QString text;
 };
 
+// file which is being read on a worker thread
+struct loadFileStruct
+{
+   DiamondTextEdit *textEdit;
+   QString fileName;
+   bool isAuto;
+
+   QTextCursor cursor;
+   FileLoader *loader;
+
+   QFrame *progressWidget;
+   QProgressBar *progressBar;
+};
+
 class MainWindow : public QMainWindow
 {
    CS_OBJECT(MainWindow)
@@ -83,13 +103,13 @@ class MainWindow : public QMainWindow
       void json_Save_MacroNames(QStringList macroNames);
       QList<macroStruct> json_View_Macro(QString macroName);
 
-      // spell
-      QStringList spell_getMaybe(QString word);
-
       // support
       QString get_DirPath(QString message, QString path);
       bool loadFile(QString fileName, bool newTab, bool isAuto, bool isReload = false);
 
+      // opens several files at once, returns the files which were opened
+      QStringList loadFiles(QStringList fileList, bool isAuto);
+
    protected:
       void closeEvent(QCloseEvent *event);
       void dragEnterEvent(QDragEnterEvent *event);
@@ -121,6 +141,32 @@ class MainWindow : public QMainWindow
       void rm_splitCombo(QString fullName);
       void update_splitCombo(QString fullName, bool isModified);
 
+      // files opened in the background, the timer moves their text into the documents
+      QList<loadFileStruct> m_loadList;
+      QTimer *m_loadTimer;
+
+      int loadFile_FindTab(const QString &fileName);
+      void loadFile_Async(const QString &fileName, qint64 fileSize, bool isAuto);
+      void loadFile_Worker(DiamondTextEdit *textEdit, const QString &fileName, qint64 fileSize, bool isAuto);
+      void loadFile_Done(const QString &fileName, bool addNewTab, bool isAuto, bool isReload);
+      void loadFile_Finish(int index);
+      void loadFile_Slice();
+      void loadFile_Cancel(DiamondTextEdit *textEdit);
+
+      // returns true if the editor was loading
+      bool loadFile_Stop(DiamondTextEdit *textEdit);
+      bool loadFile_IsLoading(DiamondTextEdit *textEdit) const;
+
+      // tab memory, unmodified tabs which have not been used for a while are unloaded to a stub
+      QTimer *m_tabMemoryTimer;
+
+      void tab_Load(DiamondTextEdit *textEdit, const QString &fileName);
+      void tab_Unload(DiamondTextEdit *textEdit);
+      void tab_CheckMemory();
+
+      // text of a tab, read from the file when the tab is a stub
+      QString tab_Text(DiamondTextEdit *textEdit, const QString &fileName);
+
       // copy buffer
       QShortcut *m_actionCopyBuffer;
 
@@ -195,7 +241,11 @@ class MainWindow : public QMainWindow
       QString m_jsonFname;
       SyntaxTypes m_syntaxEnum;
       Syntax *m_syntaxParser;
+
+      // tabs opened in a batch which have not been shown yet
+      QSet<DiamondTextEdit *> m_syntaxPending;
       void runSyntax(QString synFName);
+      void releaseSyntax(DiamondTextEdit *textEdit);
 
       // settings
       struct Arugments m_args;
@@ -221,6 +271,31 @@ class MainWindow : public QMainWindow
       void createSpellCheck();
       SpellCheck *m_spellCheck;
 
+      // polls the background dictionary load
+      QTimer *m_spellTimer;
+
+      void spell_Load();
+      void spell_Loaded();
+
+      // user dictionary is saved a short time after the last word is added
+      QTimer *m_userDictTimer;
+
+      void spell_SaveUserDict();
+
+      // spell check report
+      QFrame *m_spellWidget;
+      QStandardItemModel *m_spellModel;
+
+      // report which is running, polled by the timer
+      SpellReport *m_spellReport;
+      QProgressDialog *m_spellProgress;
+      QTimer *m_spellReportTimer;
+
+      void spell_Report(bool allTabs);
+      void spell_ReportPoll();
+      void spell_ReportStop();
+      void spell_ShowReport(const SpellReport &report);
+
       // menu bar
       QToolBar *fileToolBar;
       QToolBar *editToolBar;
@@ -232,6 +307,7 @@ class MainWindow : public QMainWindow
       // status bar
       QLabel *m_statusLine;
       QLabel *m_statusMode;
+      QLabel *m_statusSyntax;
       QLabel *m_statusName;
 
       enum Option { ABOUTURL, ADVFIND, AUTOLOAD, CLOSE, COLORS, COLUMN_MODE, DICT_MAIN, DICT_USER, FIND_LIST,
@@ -264,6 +340,7 @@ class MainWindow : public QMainWindow
 
       void setStatusBar(QString msg, int timeOut);
       void setStatus_ColMode();
+      void setStatus_SyntaxMode();
       void setStatus_FName(QString name);
       void showNotDone(QString item);
 
@@ -403,6 +480,7 @@ class MainWindow : public QMainWindow
       void macroLoad();
       void macroEditNames();
       void spellCheck();
+      void syntaxProfile();
 
       // options
       void setColors();
@@ -428,6 +506,13 @@ class MainWindow : public QMainWindow
       void advFind_View(const QModelIndex &index);
       void advFind_Close();
 
+      // spell check report
+      void spell_Document();
+      void spell_AllTabs();
+      void spell_ReportView(const QModelIndex &index);
+      void spell_ReportClose();
+      void spell_Import();
+
       // copy buffer
       void showCopyBuffer();
 
@@ -472,6 +557,12 @@ class MainWindow : public QMainWindow
       CS_SLOT_1(Private, void openTab_redo())
       CS_SLOT_2(openTab_redo)
 
+      // large file policy
+      void showContext_SyntaxMode(const QPoint &pt);
+
+      CS_SLOT_1(Private, void syntaxMode_Set())
+      CS_SLOT_2(syntaxMode_Set)
+
       // split
       void set_splitCombo();
       void split_Horizontal();
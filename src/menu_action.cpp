@@ -14,6 +14,7 @@
 
 #include "dialog_macro.h"
 #include "dialog_open.h"
+#include "dialog_profile.h"
 #include "dialog_symbols.h"
 #include "mainwindow.h"
 
@@ -152,11 +153,7 @@ void MainWindow::openDoc(QString path)
    QStringList fileList = QFileDialog::getOpenFileNames(this, tr("Select File"),
          path, tr("All Files (*)"), &selectedFilter, options);
 
-   for (const QString &fileName : fileList)  {
-      if (! fileName.isEmpty()) {
-         loadFile(fileName, true, false);
-      }
-   }
+   loadFiles(fileList, false);
 }
 
 bool MainWindow::close_Doc()
@@ -207,6 +204,10 @@ bool MainWindow::closeAll_Doc(bool isExit)
          m_textEdit = textEdit;
          m_curFile  = this->get_curFileName(whichTab);
 
+         // a partly loaded file has nothing to save
+         loadFile_Stop(textEdit);
+         m_syntaxPending.remove(textEdit);
+
          bool okClose = querySave();
 
          if (okClose)  {
@@ -1515,6 +1516,7 @@ void MainWindow::spellCheck()
    if (m_ui->actionSpell_Check->isChecked()) {
       //on
       m_struct.isSpellCheck = true;
+      spell_Load();
 
    } else {
       // off
@@ -1541,3 +1543,17 @@ void MainWindow::spellCheck()
       }
    }
 }
+
+void MainWindow::syntaxProfile()
+{
+   Syntax *parser = nullptr;
+
+   if (m_textEdit != nullptr) {
+      parser = m_textEdit->get_SyntaxParser();
+   }
+
+   Dialog_Profile *dw = new Dialog_Profile(parser);
+   dw->exec();
+
+   delete dw;
+}
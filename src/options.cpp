@@ -99,11 +99,19 @@ void MainWindow::setColors()
          if (textEdit) {
             m_textEdit = textEdit;
 
-            // get saved value
-            synFName = m_textEdit->get_SyntaxFile();
+            Syntax *parser = m_textEdit->get_SyntaxParser();
 
-            // reloads the syntax blocks based on new colors
-            runSyntax(synFName);
+            if (parser) {
+               // new colors only, the tokens cached in the blocks are reused
+               parser->processSyntax(m_struct);
+
+            } else {
+               // get saved value
+               synFName = m_textEdit->get_SyntaxFile();
+
+               // reloads the syntax blocks based on new colors
+               runSyntax(synFName);
+            }
          }
       }
 
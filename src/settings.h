@@ -22,6 +22,17 @@
 struct Settings {
    int   rewrapColumn;
    int   tabSpacing;
+   int   syntaxSliceBudget;
+
+   // large file policy, size in millions of characters, a document holds characters not bytes
+   int   largeFileSize;
+   int   largeLineLength;
+   int   largeFileMode;
+
+   // tab memory, idle time in minutes and cap in MB, zero turns either off
+   bool  tabLazyLoad;
+   int   tabUnloadMinutes;
+   int   tabMemoryCap;
 
    bool  showLineHighlight;
    bool  showLineNumbers;
@@ -199,4 +210,7 @@ enum SyntaxTypes {SYN_C, SYN_CLIPPER, SYN_CMAKE, SYN_CSS, SYN_DOXY, SYN_ERRLOG,
                   SYN_SHELL, SYN_PERL, SYN_PHP, SYN_PYTHON, SYN_XML,
                   SYN_NONE, SYN_UNUSED1, SYN_UNUSED2 };
 
+// highlighting level of a tab, large files drop to keywords or none
+enum SyntaxMode {SYNTAX_AUTO = -1, SYNTAX_FULL, SYNTAX_KEYWORDS, SYNTAX_NONE};
+
 #endif
@@ -13,11 +13,88 @@
 ***************************************************************************/
 
 #include "mainwindow.h"
+#include "spell_report.h"
 #include "spellcheck.h"
 
+#include <QBoxLayout>
+#include <QFileDialog>
+#include <QMap>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QTableView>
+
+// rows shown for each misspelled word, the count includes every occurrence
+static const int REPORT_LOCATIONS = 25;
+
 void MainWindow::createSpellCheck()
 {
+   // dictionaries are not read until spell check is turned on
    m_spellCheck = new SpellCheck(m_struct.dictMain,  m_struct.dictUser);
+   m_spellCheck->setCachePath(pathName(m_jsonFname));
+
+   m_spellTimer = new QTimer(this);
+   m_spellTimer->setInterval(50);
+
+   connect(m_spellTimer, &QTimer::timeout, this, &MainWindow::spell_Loaded);
+
+   m_spellWidget = nullptr;
+   m_spellModel  = nullptr;
+
+   m_spellReport   = nullptr;
+   m_spellProgress = nullptr;
+
+   // polls the spell check report while it runs
+   m_spellReportTimer = new QTimer(this);
+   m_spellReportTimer->setInterval(50);
+
+   connect(m_spellReportTimer, &QTimer::timeout, this, &MainWindow::spell_ReportPoll);
+
+   m_userDictTimer = new QTimer(this);
+   m_userDictTimer->setInterval(2000);
+   m_userDictTimer->setSingleShot(true);
+
+   connect(m_userDictTimer, &QTimer::timeout, this, &MainWindow::spell_SaveUserDict);
+
+   if (m_struct.isSpellCheck) {
+      // first tick is after the window is shown
+      m_spellTimer->start();
+   }
+}
+
+void MainWindow::spell_Load()
+{
+   if (! m_spellCheck->isLoaded()) {
+      m_spellTimer->start();
+   }
+}
+
+void MainWindow::spell_Loaded()
+{
+   m_spellCheck->load();
+
+   if (! m_spellCheck->isLoaded()) {
+      return;
+   }
+
+   m_spellTimer->stop();
+
+   if (! m_spellCheck->loadError().isEmpty()) {
+      csError("Spell Check", m_spellCheck->loadError());
+   }
+
+   // words added while loading could not be saved until the file was read
+   spell_SaveUserDict();
+
+   // redo the tabs which were highlighted without spelling errors
+   int count = m_tabWidget->count();
+
+   for (int k = 0; k < count; ++k)  {
+      DiamondTextEdit *textEdit = dynamic_cast<DiamondTextEdit *>(m_tabWidget->widget(k));
+
+      if (textEdit && textEdit->get_SyntaxParser()) {
+         textEdit->get_SyntaxParser()->processSyntax();
+      }
+   }
 }
 
 void MainWindow::spell_addUserDict()
@@ -29,7 +106,49 @@ void MainWindow::spell_addUserDict()
    if (! word.isEmpty()) {
       m_spellCheck->addToUserDict(word);
       cursor.insertText(word);
+
+      // restarted by every word so adding several is one write
+      m_userDictTimer->start();
+   }
+}
+
+void MainWindow::spell_SaveUserDict()
+{
+   QString error;
+
+   if (! m_spellCheck->saveUserDict(error)) {
+      csError("Spell Check", error);
+   }
+}
+
+void MainWindow::spell_Import()
+{
+   QString selectedFilter;
+   QFileDialog::Options options;
+
+   // force windows 7 and 8 to honor initial path
+   options = QFileDialog::ForceInitialDir_Win7;
+
+   QString fileName = QFileDialog::getOpenFileName(this, tr("Import Word List"),
+         m_struct.pathPrior, tr("Word List (*.txt *.dic);;All Files (*)"), &selectedFilter, options);
+
+   if (fileName.isEmpty()) {
+      return;
+   }
+
+   QString error;
+   int count = m_spellCheck->importUserDict(fileName, error);
+
+   if (count < 0) {
+      csError("Import Word List", error);
+      return;
+   }
+
+   if (count > 0) {
+      m_userDictTimer->start();
    }
+
+   csMsg(this, tr("Import Word List"), tr("%1 words were added to the user dictionary.").formatArg(count));
 }
 
 void MainWindow::spell_replaceWord()
@@ -44,12 +163,260 @@ void MainWindow::spell_replaceWord()
    }
 }
 
-QStringList MainWindow::spell_getMaybe(QString word)
+void MainWindow::spell_Document()
+{
+   spell_Report(false);
+}
+
+void MainWindow::spell_AllTabs()
+{
+   spell_Report(true);
+}
+
+void MainWindow::spell_Report(bool allTabs)
 {
-   if ( m_spellCheck->spell(word) )   {
-      return QStringList();
+   if (m_spellReport != nullptr) {
+      // one report at a time
+      return;
+   }
+
+   QVector<SpellReportDocument> documentList;
+
+   auto addDocument = [this, &documentList] (DiamondTextEdit *textEdit, const QString &fileName) {
+      SpellReportDocument document;
+      document.fileName = fileName;
+
+      Syntax *parser = textEdit->get_SyntaxParser();
+
+      if (parser) {
+         document.definition = parser->get_Definition();
+      }
+
+      // a tab which has not been read yet is checked from the file
+      document.lineList = tab_Text(textEdit, fileName).split("\n");
+      documentList.append(document);
+   };
+
+   if (allTabs) {
+      int count = m_tabWidget->count();
+
+      for (int k = 0; k < count; ++k)  {
+         DiamondTextEdit *textEdit = dynamic_cast<DiamondTextEdit *>(m_tabWidget->widget(k));
+
+         if (textEdit) {
+            addDocument(textEdit, m_tabWidget->tabWhatsThis(k));
+         }
+      }
+
    } else {
-      return m_spellCheck->suggest(word);
+      addDocument(m_textEdit, m_curFile.isEmpty() ? QString("untitled.txt") : m_curFile);
+
+   }
+
+   m_spellReport = new SpellReport(m_spellCheck, documentList);
+
+   m_spellProgress = new QProgressDialog(this);
+
+   m_spellProgress->setWindowModality(Qt::WindowModal);
+   m_spellProgress->setMinimumDuration(1000);
+   m_spellProgress->setMinimumWidth(275);
+   m_spellProgress->setRange(0, m_spellReport->lineCount());
+   m_spellProgress->setWindowTitle(tr("Spell Check"));
+   m_spellProgress->setLabelText(tr("Checking %1 lines").formatArg(m_spellReport->lineCount()));
+
+   m_spellProgress->setCancelButtonText(tr("&Cancel"));
+   m_spellProgress->setCancelButtonCentered(true);
+
+   // every worker loads the dictionary first, the time is counted in the progress
+   m_spellReport->start();
+   m_spellReportTimer->start();
+}
+
+void MainWindow::spell_ReportPoll()
+{
+   if (m_spellProgress->wasCanceled()) {
+      spell_ReportStop();
+
+      return;
+   }
+
+   m_spellProgress->setValue(m_spellReport->linesDone());
+
+   if (! m_spellReport->isFinished()) {
+      return;
+   }
+
+   m_spellProgress->close();
+
+   if (m_spellReport->errorList().isEmpty()) {
+      spell_ReportStop();
+      QMessageBox::information(this, tr("Spell Check"), tr("No spelling errors were found."));
+
+      return;
+   }
+
+   spell_ShowReport(*m_spellReport);
+   spell_ReportStop();
+}
+
+void MainWindow::spell_ReportStop()
+{
+   // the destructor cancels the report and waits for the workers
+   m_spellReportTimer->stop();
+
+   delete m_spellReport;
+   m_spellReport = nullptr;
+
+   m_spellProgress->deleteLater();
+   m_spellProgress = nullptr;
+}
+
+void MainWindow::spell_ShowReport(const SpellReport &report)
+{
+   if (m_spellWidget != nullptr) {
+      m_spellWidget->deleteLater();
+   }
+
+   // group the errors by word, each word keeps document order
+   QMap<QString, QVector<int>> wordList;
+
+   const QVector<SpellReportError> &errorList = report.errorList();
+
+   for (int k = 0; k < errorList.size(); ++k) {
+      wordList[errorList[k].word].append(k);
+   }
+
+   // create the report window
+   m_spellWidget = new QFrame(this);
+   m_spellWidget->setFrameShape(QFrame::Panel);
+
+   QTableView *view = new QTableView(this);
+
+   m_spellModel = new QStandardItemModel(m_spellWidget);
+   m_spellModel->setColumnCount(4);
+   m_spellModel->setHeaderData(0, Qt::Horizontal, tr("Word"));
+   m_spellModel->setHeaderData(1, Qt::Horizontal, tr("Count"));
+   m_spellModel->setHeaderData(2, Qt::Horizontal, tr("File Name"));
+   m_spellModel->setHeaderData(3, Qt::Horizontal, tr("Line #"));
+
+   view->setModel(m_spellModel);
+
+   view->setSelectionMode(QAbstractItemView::SingleSelection);
+   view->setSelectionBehavior(QAbstractItemView::SelectRows);
+   view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+   view->setColumnWidth(0, 200);
+   view->setColumnWidth(1, 75);
+   view->setColumnWidth(2, 300);
+
+   view->horizontalHeader()->setStretchLastSection(true);
+
+   // background color
+   view->setAlternatingRowColors(true);
+   view->setStyleSheet("alternate-background-color: lightyellow");
+
+   int row = 0;
+
+   for (auto iter = wordList.constBegin(); iter != wordList.constEnd(); ++iter) {
+      const QVector<int> &indexList = iter.value();
+      int cnt = std::min<int>(indexList.size(), REPORT_LOCATIONS);
+
+      for (int k = 0; k < cnt; ++k) {
+         const SpellReportError &error = errorList[indexList[k]];
+
+         QStandardItem *item0  = new QStandardItem(error.word);
+         QStandardItem *item1  = new QStandardItem(QString::number(indexList.size()));
+         QStandardItem *item2  = new QStandardItem(report.documentList()[error.document].fileName);
+         QStandardItem *item3  = new QStandardItem(QString::number(error.line + 1));
+
+         // used to select the word
+         item3->setData(error.column, Qt::UserRole);
+
+         m_spellModel->insertRow(row);
+         m_spellModel->setItem(row, 0, item0);
+         m_spellModel->setItem(row, 1, item1);
+         m_spellModel->setItem(row, 2, item2);
+         m_spellModel->setItem(row, 3, item3);
+
+         ++row;
+      }
+   }
+
+   //
+   QLabel *label = new QLabel();
+   label->setText(tr("%1 misspelled words, %2 occurrences").formatArg(wordList.size()).formatArg(errorList.size()));
+
+   QPushButton *closeButton = new QPushButton();
+   closeButton->setText("Close");
+
+   QBoxLayout *buttonLayout = new QHBoxLayout();
+   buttonLayout->addWidget(label);
+   buttonLayout->addStretch();
+   buttonLayout->addWidget(closeButton);
+   buttonLayout->addStretch();
+
+   QBoxLayout *layout = new QVBoxLayout();
+   layout->addWidget(view);
+   layout->addLayout(buttonLayout);
+
+   m_spellWidget->setLayout(layout);
+
+   m_splitter->setOrientation(Qt::Vertical);
+   m_splitter->addWidget(m_spellWidget);
+
+   // must call after addWidget
+   view->resizeRowsToContents();
+
+   connect(view,        &QTableView::clicked,  this, &MainWindow::spell_ReportView);
+   connect(closeButton, &QPushButton::clicked, this, &MainWindow::spell_ReportClose);
+}
+
+void MainWindow::spell_ReportClose()
+{
+   m_spellWidget->deleteLater();
+
+   m_spellWidget = nullptr;
+   m_spellModel  = nullptr;
+}
+
+void MainWindow::spell_ReportView(const QModelIndex &index)
+{
+   int row = index.row();
+
+   if (row < 0 || m_spellModel == nullptr) {
+      return;
+   }
+
+   QString word     = m_spellModel->item(row, 0)->data(Qt::DisplayRole).toString();
+   QString fileName = m_spellModel->item(row, 2)->data(Qt::DisplayRole).toString();
+   int lineNumber   = m_spellModel->item(row, 3)->data(Qt::DisplayRole).toInt();
+   int column       = m_spellModel->item(row, 3)->data(Qt::UserRole).toInt();
+
+   // is the file still open?
+   bool open = false;
+   int max   = m_tabWidget->count();
+
+   for (int index = 0; index < max; ++index) {
+
+      if (m_tabWidget->tabWhatsThis(index) == fileName) {
+         m_tabWidget->setCurrentIndex(index);
+
+         open = true;
+         break;
+      }
+   }
+
+   if (! open && fileName != "untitled.txt") {
+      open = loadFile(fileName, true, false);
+   }
+
+   if (open)   {
+      QTextCursor cursor(m_textEdit->textCursor());
+      cursor.movePosition(QTextCursor::Start);
+      cursor.movePosition(QTextCursor::NextBlock, QTextCursor::MoveAnchor, lineNumber - 1);
+      cursor.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor, column);
+      cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, word.length());
+      m_textEdit->setTextCursor(cursor);
    }
 }
 
@@ -303,15 +670,76 @@ void MainWindow::forceSyntax(SyntaxTypes data)
    }
 }
 
+void MainWindow::releaseSyntax(DiamondTextEdit *textEdit)
+{
+   Syntax *oldParser = textEdit->get_SyntaxParser();
+
+   if (oldParser) {
+      textEdit->set_SyntaxParser(0);
+
+      if (m_syntaxParser == oldParser) {
+         m_syntaxParser = 0;
+      }
+
+      delete oldParser;
+   }
+}
+
 void MainWindow::runSyntax(QString synFName)
 {
    // save syntax file name
    m_textEdit->set_SyntaxFile(synFName);
 
+   // release the parser this tab had, otherwise both would highlight the same document
+   releaseSyntax(m_textEdit);
+
    m_syntaxParser = new Syntax(m_textEdit->document(), synFName, m_struct, m_spellCheck);
+   m_syntaxParser->set_SyntaxType(m_syntaxEnum);
+   m_syntaxParser->set_ModeOverride(m_textEdit->get_SyntaxMode());
 
    if ( m_syntaxParser->processSyntax() ) {
       m_textEdit->set_SyntaxParser(m_syntaxParser);
    }
+
+   setStatus_SyntaxMode();
 }
 
+void MainWindow::showContext_SyntaxMode(const QPoint &pt)
+{
+   SyntaxMode current = m_textEdit->get_SyntaxMode();
+
+   QMenu *menu = new QMenu(this);
+
+   menu->addAction(tr("Automatic"),         this, SLOT(syntaxMode_Set()) )->setData(SYNTAX_AUTO);
+   menu->addAction(tr("Full Highlighting"), this, SLOT(syntaxMode_Set()) )->setData(SYNTAX_FULL);
+   menu->addAction(tr("Keywords Only"),     this, SLOT(syntaxMode_Set()) )->setData(SYNTAX_KEYWORDS);
+   menu->addAction(tr("No Highlighting"),   this, SLOT(syntaxMode_Set()) )->setData(SYNTAX_NONE);
+
+   for (QAction *action : menu->actions()) {
+      action->setCheckable(true);
+      action->setChecked(action->data().toInt() == current);
+   }
+
+   menu->exec(m_statusSyntax->mapToGlobal(pt));
+   delete menu;
+}
+
+void MainWindow::syntaxMode_Set()
+{
+   QAction *action;
+   action = (QAction *)sender();
+
+   if (action) {
+      SyntaxMode mode = static_cast<SyntaxMode>(action->data().toInt());
+      m_textEdit->set_SyntaxMode(mode);
+
+      Syntax *parser = m_textEdit->get_SyntaxParser();
+
+      if (parser) {
+         parser->set_ModeOverride(mode);
+         parser->processSyntax();
+      }
+
+      setStatus_SyntaxMode();
+   }
+}
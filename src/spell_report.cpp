@@ -0,0 +1,204 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#include "spell_report.h"
+
+#include <algorithm>
+#include <future>
+
+// lines handed to a worker at a time
+static const int CHUNK_LINES = 2000;
+
+// every worker loads its own copy of the dictionary
+static const int MAX_WORKERS = 8;
+
+SpellReport::SpellReport(SpellCheck *spellCheck, QVector<SpellReportDocument> documentList)
+   : m_spellCheck(spellCheck), m_documentList(std::move(documentList))
+{
+   m_nextChunk   = 0;
+   m_lineCount   = 0;
+   m_linesDone   = 0;
+   m_isCancelled = false;
+   m_isFinished  = false;
+
+   for (int k = 0; k < m_documentList.size(); ++k) {
+      int cnt = m_documentList[k].lineList.size();
+
+      m_resultList.emplace_back(cnt);
+      m_lineCount += cnt;
+
+      for (int first = 0; first < cnt; first += CHUNK_LINES) {
+         m_chunkList.push_back( {k, first, std::min(first + CHUNK_LINES, cnt)} );
+      }
+   }
+}
+
+SpellReport::~SpellReport()
+{
+   cancel();
+
+   if (m_thread.joinable()) {
+      m_thread.join();
+   }
+}
+
+void SpellReport::start()
+{
+   m_thread = std::thread(&SpellReport::run, this);
+}
+
+void SpellReport::cancel()
+{
+   m_isCancelled = true;
+}
+
+bool SpellReport::isFinished() const
+{
+   return m_isFinished;
+}
+
+bool SpellReport::isCancelled() const
+{
+   return m_isCancelled;
+}
+
+int SpellReport::linesDone() const
+{
+   return m_linesDone;
+}
+
+int SpellReport::lineCount() const
+{
+   return m_lineCount;
+}
+
+const QVector<SpellReportDocument> &SpellReport::documentList() const
+{
+   return m_documentList;
+}
+
+const QVector<SpellReportError> &SpellReport::errorList() const
+{
+   return m_errorList;
+}
+
+int SpellReport::checkLine(SpellCheck *checker, int document, int line, int prevState)
+{
+   const SpellReportDocument &item = m_documentList[document];
+   LineResult &result = m_resultList[document][line];
+
+   result.prevState = prevState;
+   result.runList.clear();
+   result.endState  = Syntax::spellBlock(item.definition.get(), checker, item.lineList[line], prevState, result.runList);
+
+   return result.endState;
+}
+
+SpellCheck *SpellReport::runWorker()
+{
+   SpellCheck *checker = m_spellCheck->takeClone();
+
+   while (! m_isCancelled) {
+      int index = m_nextChunk++;
+
+      if (index >= static_cast<int>(m_chunkList.size())) {
+         break;
+      }
+
+      const Chunk &chunk = m_chunkList[index];
+      int state = (chunk.first == 0) ? -1 : 0;
+
+      for (int k = chunk.first; k < chunk.last && ! m_isCancelled; ++k) {
+         state = checkLine(checker, chunk.document, k, state);
+         ++m_linesDone;
+      }
+   }
+
+   return checker;
+}
+
+void SpellReport::run()
+{
+   int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+   threads = std::min<int>({threads, MAX_WORKERS, static_cast<int>(m_chunkList.size())});
+
+   std::vector<std::future<SpellCheck *>> futureList;
+
+   for (int k = 0; k < threads; ++k) {
+      futureList.push_back(std::async(std::launch::async, &SpellReport::runWorker, this));
+   }
+
+   std::vector<SpellCheck *> checkerList;
+
+   for (auto &item : futureList) {
+      checkerList.push_back(item.get());
+   }
+
+   // checkers go back to the pool of the main one for the next report or syntax pass
+   for (std::size_t k = 1; k < checkerList.size(); ++k) {
+      m_spellCheck->releaseClone(checkerList[k]);
+   }
+
+   if (checkerList.empty()) {
+      m_isFinished = true;
+      return;
+   }
+
+   SpellCheck *checker = checkerList.front();
+
+   if (m_isCancelled) {
+      m_spellCheck->releaseClone(checker);
+
+      m_isFinished = true;
+      return;
+   }
+
+   // a comment still open at the end of a chunk changes the scope of the next one, redo lines
+   // until the start state agrees with the one assumed for the chunk
+   for (const Chunk &chunk : m_chunkList) {
+
+      if (chunk.first == 0) {
+         continue;
+      }
+
+      const std::vector<LineResult> &resultList = m_resultList[chunk.document];
+
+      int cnt   = resultList.size();
+      int state = resultList[chunk.first - 1].endState;
+      int k     = chunk.first;
+
+      while (k < cnt && resultList[k].prevState != state) {
+         state = checkLine(checker, chunk.document, k, state);
+         ++k;
+      }
+   }
+
+   for (int document = 0; document < m_documentList.size(); ++document) {
+      const QStringList &lineList = m_documentList[document].lineList;
+      const std::vector<LineResult> &resultList = m_resultList[document];
+
+      for (int line = 0; line < lineList.size(); ++line) {
+         for (const SyntaxRun &run : resultList[line].runList) {
+            m_errorList.append( {document, line, run.start, lineList[line].mid(run.start, run.length)} );
+         }
+      }
+   }
+
+   m_spellCheck->releaseClone(checker);
+
+   // the line results are no longer needed
+   m_resultList.clear();
+
+   m_isFinished = true;
+}
@@ -0,0 +1,109 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#ifndef SPELL_REPORT_H
+#define SPELL_REPORT_H
+
+#include "spellcheck.h"
+#include "syntax.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// one document to check, the text is copied so the tab can be edited while the report runs
+struct SpellReportDocument
+{
+   QString fileName;
+   std::shared_ptr<const SyntaxDefinition> definition;
+   QStringList lineList;
+};
+
+// line and column are zero based
+struct SpellReportError
+{
+   int document;
+   int line;
+   int column;
+   QString word;
+};
+
+// spell checks whole documents on a pool of threads, each thread has its own hunspell
+class SpellReport
+{
+   public:
+      SpellReport(SpellCheck *spellCheck, QVector<SpellReportDocument> documentList);
+      ~SpellReport();
+
+      void start();
+      void cancel();
+
+      bool isFinished() const;
+      bool isCancelled() const;
+
+      int linesDone() const;
+      int lineCount() const;
+
+      const QVector<SpellReportDocument> &documentList() const;
+
+      // valid once finished, in document and text order
+      const QVector<SpellReportError> &errorList() const;
+
+   private:
+      struct LineResult
+      {
+         int prevState;
+         int endState;
+         QVector<SyntaxRun> runList;
+      };
+
+      // lines of one document, every chunk assumes the normal start state
+      struct Chunk
+      {
+         int document;
+         int first;
+         int last;
+      };
+
+      SpellCheck *m_spellCheck;
+
+      QVector<SpellReportDocument> m_documentList;
+      QVector<SpellReportError> m_errorList;
+
+      // indexed by document and line
+      std::vector<std::vector<LineResult>> m_resultList;
+
+      std::vector<Chunk> m_chunkList;
+      std::atomic<int> m_nextChunk;
+
+      int m_lineCount;
+      std::atomic<int> m_linesDone;
+
+      std::atomic<bool> m_isCancelled;
+      std::atomic<bool> m_isFinished;
+
+      std::thread m_thread;
+
+      void run();
+      SpellCheck *runWorker();
+
+      int checkLine(SpellCheck *checker, int document, int line, int prevState);
+};
+
+#endif
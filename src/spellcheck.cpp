@@ -17,10 +17,19 @@
 
 #include <hunspell.hxx>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
 #include <QByteArray>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
 #include <QTextCodec>
-#include <QTextStream>
 
 #if defined (H_DEPRECATED)
 // could be version 1.5, 1.6, or 1.7
@@ -32,51 +41,240 @@
 
 #endif
 
+// number of cached verdicts, must be a power of two
+static const int CACHE_SIZE = 8192;
+
+// words with cached suggestions
+static const int SUGGEST_CACHE_SIZE = 256;
+
+// word list file, the header is followed by count + 1 offsets and the text of the words
+static const quint32 WORDLIST_MAGIC   = 0x44535744;
+static const quint32 WORDLIST_VERSION = 1;
+
+struct WordListHeader
+{
+   quint32 magic;
+   quint32 version;
+
+   qint64 dicSize;
+   qint64 dicModified;
+   qint64 affSize;
+   qint64 affModified;
+
+   quint32 count;
+   quint32 textSize;
+};
+
+static_assert(sizeof(WordListHeader) % sizeof(quint32) == 0, "offsets after the header must be aligned");
+
 // debian 9 uses 1.4.1
 // ubuntu 16.04 uses 1.3.3
 // all other supported platforms use 1.5 or newer
 
 SpellCheck::SpellCheck(const QString &dictMain, const QString &dictUser)
 {
+   m_mainFname = dictMain;
    m_userFname = dictUser;
+   m_revision  = 0;
 
-   QString base = dictMain;
-   base = base.mid(0, base.indexOf("."));
+   m_hunspell  = nullptr;
+   m_isLoaded  = false;
+   m_isLoading = false;
+   m_isClone   = false;
+   m_stop      = false;
 
-   QString dicFname  = base + ".dic";
-   QString affFName  = base + ".aff";
+   m_wordLogCount = 0;
 
-   m_hunspell = new Hunspell(affFName .constData(), dicFname.constData() );
+   m_isSuggestReady = false;
+
+   m_isUserDirty    = false;
+   m_isUserReadable = true;
+
+   m_cache.resize(CACHE_SIZE);
+   clearCache();
 
    // encode as SET option in the affix file
    m_codec = QTextCodec::codecForName("UTF-8");
+}
+
+SpellCheck::~SpellCheck()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_suggestMutex);
+      m_stop = true;
+   }
+
+   m_suggestCondition.notify_one();
+
+   if (m_suggestThread.joinable()) {
+      m_suggestThread.join();
+   }
+
+   if (m_loadThread.joinable()) {
+      m_loadThread.join();
+   }
+
+   for (SpellCheck *item : m_clonePool) {
+      delete item;
+   }
+
+   delete m_hunspell;
+}
+
+SpellCheck::WordList::WordList()
+{
+   file    = nullptr;
+   offsets = nullptr;
+   text    = nullptr;
+   count   = 0;
+}
+
+SpellCheck::WordList::~WordList()
+{
+   delete file;
+}
+
+void SpellCheck::setCachePath(const QString &path)
+{
+   m_cachePath = path;
+}
+
+void SpellCheck::load()
+{
+   if (m_isLoading) {
+      return;
+   }
+
+   m_isLoading  = true;
+   m_loadThread = std::thread(&SpellCheck::loadDictionary, this);
+}
+
+bool SpellCheck::isLoaded() const
+{
+   return m_isLoaded;
+}
+
+QString SpellCheck::loadError() const
+{
+   return m_loadError;
+}
+
+void SpellCheck::dictFiles(QString &dicFname, QString &affFname) const
+{
+   QString base = m_mainFname;
+   base = base.mid(0, base.indexOf("."));
+
+   dicFname = base + ".dic";
+   affFname = base + ".aff";
+}
+
+void SpellCheck::loadDictionary()
+{
+   // runs on the load thread, the main dictionary is large so it is read without holding the lock
+   QString dicFname;
+   QString affFName;
+
+   dictFiles(dicFname, affFName);
+
+   Hunspell *hunspell = new Hunspell(affFName .constData(), dicFname.constData() );
+
+   // clones share the word list of the checker they were made from
+   std::shared_ptr<const WordList> dictWords;
+
+   if (! m_isClone) {
+      dictWords = loadWordList(dicFname, affFName);
+   }
+
+   QSet<QString> wordList;
+   QString error;
+
+   bool isReadable = true;
 
    if (! m_userFname.isEmpty()) {
       QFile file(m_userFname);
 
-      if (! file.open(QFile::ReadOnly)) {
-         QString error = QObject::tr("Unable to read file %1:\n%2.").formatArgs(m_userFname, file.errorString());
-         csError("Spell Check", error);
-         return;
+      if (file.open(QFile::ReadOnly)) {
+         // one pass over the whole file, blank lines and duplicates are skipped
+         const QByteArray data = file.readAll();
+         file.close();
+
+         for (const QByteArray &line : data.split('\n')) {
+            QString word = QString::fromUtf8(line).trimmed();
+
+            if (! word.isEmpty()) {
+               wordList.insert(word);
+            }
+         }
+
+      } else {
+         error = QObject::tr("Unable to read file %1:\n%2.").formatArgs(m_userFname, file.errorString());
+
+         // saving would replace the words which could not be read
+         isReadable = ! file.exists();
       }
 
-      QTextStream stream(&file);
+   } else if (! m_isClone) {
+      error = "Unable to find User Dictionary " + m_userFname;
 
-      for (QString word(stream.readLine()); ! word.isEmpty(); word = stream.readLine()) {
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   m_hunspell       = hunspell;
+   m_loadError      = error;
+
+   if (! m_isClone) {
+      m_wordList = dictWords;
+   }
+
+   m_isUserReadable = isReadable;
+
+   for (const QString &word : wordList) {
+      if (! m_userWords.contains(word)) {
+         m_userWords.insert(word);
          put_word(word);
       }
+   }
 
-      file.close();
+   for (const QString &word : m_pendingList) {
+      put_word(word);
+   }
 
-   } else {
-      csError("Spell Check", "Unable to find User Dictionary " + m_userFname);
+   m_pendingList.clear();
 
-   }
+   // blocks checked while loading have no spelling errors, the new revision marks them stale
+   clearCache();
+   ++m_revision;
+
+   m_isLoaded = true;
 }
 
-SpellCheck::~SpellCheck()
+static int encodeUtf8(char32_t value, char *bytes)
 {
-   delete m_hunspell;
+   if (value < 0x80) {
+      bytes[0] = value;
+      return 1;
+   }
+
+   if (value < 0x800) {
+      bytes[0] = 0xc0 | (value >> 6);
+      bytes[1] = 0x80 | (value & 0x3f);
+      return 2;
+   }
+
+   if (value < 0x10000) {
+      bytes[0] = 0xe0 | (value >> 12);
+      bytes[1] = 0x80 | ((value >> 6) & 0x3f);
+      bytes[2] = 0x80 | (value & 0x3f);
+      return 3;
+   }
+
+   bytes[0] = 0xf0 | (value >> 18);
+   bytes[1] = 0x80 | ((value >> 12) & 0x3f);
+   bytes[2] = 0x80 | ((value >> 6) & 0x3f);
+   bytes[3] = 0x80 | (value & 0x3f);
+
+   return 4;
 }
 
 bool SpellCheck::spell(QStringView word)
@@ -91,24 +289,205 @@ bool SpellCheck::spell(QStringView word)
       word = word.mid(1);
    }
 
+   // encoded on the stack so a cache hit does not allocate, long words are not cached
+   char buffer[CACHE_WORD_SIZE + 1];
+   int length    = 0;
+   bool isCached = true;
+   uint hash     = 2166136261u;
+
+   for (QChar c : word) {
+      char bytes[4];
+      int cnt = encodeUtf8(c.unicode(), bytes);
+
+      if (length + cnt > CACHE_WORD_SIZE) {
+         isCached = false;
+         break;
+      }
+
+      for (int k = 0; k < cnt; ++k) {
+         buffer[length] = bytes[k];
+         hash = (hash ^ static_cast<unsigned char>(bytes[k])) * 16777619u;
+
+         ++length;
+      }
+   }
+
+   buffer[length] = '\0';
+
+   if (! m_isLoaded) {
+      // still loading
+      return true;
+   }
+
+   SpellEntry *entry = nullptr;
+
+   if (isCached) {
+      std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+
+      entry = &m_cache[hash & (CACHE_SIZE - 1)];
+
+      if (entry->isUsed && entry->hash == hash && entry->length == length &&
+            std::memcmp(entry->word, buffer, length) == 0) {
+         return entry->isCorrect;
+      }
+   }
+
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   if (isCached && (isAccepted(buffer, length) || m_addedWords.contains(QByteArray::fromRawData(buffer, length)))) {
+      // plain dictionary word or a word the user added, no affix processing needed
+      isCorrect = true;
+
+   } else {
+
 #if (HUNSPELL_VERSION >= 5)
-   isCorrect = m_hunspell->spell(QString(word).toStdString());
+      if (isCached) {
+         isCorrect = m_hunspell->spell(std::string(buffer, length));
+      } else {
+         isCorrect = m_hunspell->spell(QString(word).toStdString());
+      }
 
 #else
-   isCorrect = m_hunspell->spell(m_codec->fromUnicode(word).constData()) != 0;
+      if (isCached) {
+         isCorrect = m_hunspell->spell(buffer) != 0;
+      } else {
+         isCorrect = m_hunspell->spell(m_codec->fromUnicode(word).constData()) != 0;
+      }
 
 #endif
+   }
+
+   if (entry != nullptr) {
+      std::lock_guard<std::mutex> cacheLock(m_cacheMutex);
+
+      entry->hash      = hash;
+      entry->isUsed    = true;
+      entry->isCorrect = isCorrect;
+      entry->length    = length;
+
+      std::memcpy(entry->word, buffer, length);
+   }
 
    return isCorrect;
 }
 
-QStringList SpellCheck::suggest(const QString &word)
+void SpellCheck::clearCache()
+{
+   // a new word can also change the verdict for other forms of it, drop everything
+   {
+      std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+      for (auto &entry : m_cache) {
+         entry.isUsed = false;
+      }
+   }
+
+   std::lock_guard<std::mutex> lock(m_suggestMutex);
+   m_suggestList.clear();
+}
+
+bool SpellCheck::suggestCached(const QString &word, QStringList &list)
+{
+   std::lock_guard<std::mutex> lock(m_suggestMutex);
+
+   auto iter = m_suggestList.constFind(word);
+
+   if (iter != m_suggestList.constEnd()) {
+      list = iter.value();
+      return true;
+   }
+
+   // only the last word asked for is looked up, an older request is dropped
+   m_suggestWord = word;
+
+   if (! m_suggestThread.joinable()) {
+      m_suggestThread = std::thread(&SpellCheck::suggestLoop, this);
+   }
+
+   m_suggestCondition.notify_one();
+
+   return false;
+}
+
+void SpellCheck::suggestLoop()
+{
+   // suggest() is slow, this thread has its own hunspell so spell() never waits behind it
+   std::unique_ptr<Hunspell> hunspell;
+
+   while (true) {
+      QString word;
+
+      {
+         std::unique_lock<std::mutex> lock(m_suggestMutex);
+         m_suggestCondition.wait(lock, [this] () { return m_stop || ! m_suggestWord.isEmpty(); } );
+
+         if (m_stop) {
+            return;
+         }
+
+         word = m_suggestWord;
+         m_suggestWord.clear();
+      }
+
+      if (! m_isLoaded) {
+         // asked again once the dictionary is ready
+         continue;
+      }
+
+      if (hunspell == nullptr) {
+         QStringList wordList;
+
+         {
+            // words added from here on are passed on by put_word()
+            std::lock_guard<std::mutex> lock(m_mutex);
+            wordList = m_ignoreList + m_userWords.toList();
+
+            std::lock_guard<std::mutex> suggestLock(m_suggestMutex);
+            m_isSuggestReady = true;
+         }
+
+         QString dicFname;
+         QString affFname;
+
+         dictFiles(dicFname, affFname);
+
+         hunspell.reset(new Hunspell(affFname.constData(), dicFname.constData()));
+
+         for (const QString &item : wordList) {
+            hunspell->add(m_codec->fromUnicode(item).constData());
+         }
+      }
+
+      QStringList addedList;
+
+      {
+         std::lock_guard<std::mutex> lock(m_suggestMutex);
+         addedList.swap(m_suggestAdded);
+      }
+
+      for (const QString &item : addedList) {
+         hunspell->add(m_codec->fromUnicode(item).constData());
+      }
+
+      QStringList list = suggest(hunspell.get(), word);
+
+      std::lock_guard<std::mutex> lock(m_suggestMutex);
+
+      if (m_suggestList.size() >= SUGGEST_CACHE_SIZE) {
+         m_suggestList.clear();
+      }
+
+      m_suggestList.insert(word, list);
+   }
+}
+
+QStringList SpellCheck::suggest(Hunspell *hunspell, const QString &word)
 {
    QStringList suggestions;
 
 #if (HUNSPELL_VERSION >= 5)
 
-   QVector<std::string> suggestWordList = QVector<std::string>::fromStdVector(m_hunspell->suggest(word.toStdString()));
+   QVector<std::string> suggestWordList = QVector<std::string>::fromStdVector(hunspell->suggest(word.toStdString()));
 
    for (auto item : suggestWordList) {
       suggestions.append(QString::fromStdString(item));
@@ -116,13 +495,13 @@ QStringList SpellCheck::suggest(const QString &word)
 #else
    char **suggestWordList;
 
-   const int cnt = m_hunspell->suggest(&suggestWordList, m_codec->fromUnicode(word).constData());
+   const int cnt = hunspell->suggest(&suggestWordList, m_codec->fromUnicode(word).constData());
 
    for (int k = 0; k < cnt; ++k) {
       suggestions.append( m_codec->toUnicode(suggestWordList[k]) );
    }
 
-   m_hunspell->free_list(&suggestWordList, cnt);
+   hunspell->free_list(&suggestWordList, cnt);
 #endif
 
    return suggestions;
@@ -130,42 +509,606 @@ QStringList SpellCheck::suggest(const QString &word)
 
 void SpellCheck::ignoreWord(const QString &word)
 {
+   std::lock_guard<std::mutex> lock(m_mutex);
+
    put_word(word);
+   m_ignoreList.append(word);
+
+   clearCache();
+
+   ++m_revision;
+}
+
+int SpellCheck::revision() const
+{
+   return m_revision;
+}
+
+SpellCheck *SpellCheck::clone()
+{
+   // user words are copied from memory since the latest ones may not be saved yet
+   SpellCheck *retval = new SpellCheck(m_mainFname, QString());
+   retval->setCachePath(m_cachePath);
+   retval->m_isClone = true;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      retval->m_pendingList  = m_ignoreList + m_userWords.toList();
+      retval->m_wordLogCount = m_wordLog.size();
+
+      // the word list is not built again, a clone made before the dictionary is loaded uses hunspell only
+      retval->m_wordList = m_wordList;
+   }
+
+   retval->m_isLoading = true;
+   retval->loadDictionary();
+
+   return retval;
+}
+
+SpellCheck *SpellCheck::takeClone()
+{
+   SpellCheck *retval = nullptr;
+
+   {
+      std::lock_guard<std::mutex> lock(m_poolMutex);
+
+      if (! m_clonePool.empty()) {
+         retval = m_clonePool.back();
+         m_clonePool.pop_back();
+      }
+   }
+
+   if (retval == nullptr) {
+      return clone();
+   }
+
+   QStringList wordList;
+   std::shared_ptr<const WordList> dictWords;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      wordList  = m_wordLog.mid(retval->m_wordLogCount);
+      dictWords = m_wordList;
+
+      retval->m_wordLogCount = m_wordLog.size();
+   }
+
+   std::lock_guard<std::mutex> lock(retval->m_mutex);
+
+   if (! retval->m_wordList) {
+      // pooled before the dictionary of this checker was loaded
+      retval->m_wordList = dictWords;
+   }
+
+   if (! wordList.isEmpty()) {
+      for (const QString &word : wordList) {
+         retval->put_word(word);
+      }
+
+      retval->clearCache();
+   }
+
+   return retval;
+}
+
+void SpellCheck::releaseClone(SpellCheck *spellCheck)
+{
+   std::lock_guard<std::mutex> lock(m_poolMutex);
+   m_clonePool.push_back(spellCheck);
 }
 
 void SpellCheck::put_word(const QString &word)
 {
-   m_hunspell->add(m_codec->fromUnicode(word).constData());
+   {
+      std::lock_guard<std::mutex> lock(m_suggestMutex);
+
+      if (m_isSuggestReady) {
+         m_suggestAdded.append(word);
+      }
+   }
+
+   if (m_hunspell == nullptr) {
+      m_pendingList.append(word);
+      return;
+   }
+
+   QByteArray data = m_codec->fromUnicode(word);
+
+   m_addedWords.insert(data);
+   m_hunspell->add(data.constData());
+
+   if (! m_isClone) {
+      m_wordLog.append(word);
+   }
+}
+
+static QString userWord(const QString &word)
+{
+   // remove non letters
+   QString retval = word.trimmed();
+
+   while ( ! retval.isEmpty() && ! retval.at(0).isLetter()) {
+      retval = retval.mid(1);
+   }
+
+   return retval;
 }
 
 void SpellCheck::addToUserDict(const QString &word)
 {
-   // remove non letters
-   QString lookUp(word);
+   QString lookUp = userWord(word);
 
-   while ( ! lookUp.isEmpty() && ! lookUp.at(0).isLetter()) {
-      lookUp = lookUp.mid(1);
+   if (lookUp.isEmpty()) {
+      return;
    }
 
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   if (m_userWords.contains(lookUp)) {
+      return;
+   }
+
+   m_userWords.insert(lookUp);
+   m_isUserDirty = true;
+
    put_word(lookUp);
+   clearCache();
 
-   if (! m_userFname.isEmpty()) {
+   ++m_revision;
+}
 
-      QFile file(m_userFname);
+int SpellCheck::importUserDict(const QString &fileName, QString &error)
+{
+   QFile file(fileName);
+
+   if (! file.open(QFile::ReadOnly)) {
+      error = QObject::tr("Unable to read file %1:\n%2.").formatArgs(fileName, file.errorString());
+      return -1;
+   }
+
+   const QByteArray data = file.readAll();
+   file.close();
+
+   int retval = 0;
+
+   std::lock_guard<std::mutex> lock(m_mutex);
 
-      if (! file.open(QFile::Append)) {
-         QString error = QObject::tr("Unable to read file %1:\n%2.").formatArgs(m_userFname, file.errorString());
-         csError("Spell Check", error);
-         return;
+   for (const QByteArray &line : data.split('\n')) {
+      QString word = userWord(QString::fromUtf8(line));
+
+      if (word.isEmpty() || m_userWords.contains(word)) {
+         continue;
+      }
+
+      m_userWords.insert(word);
+      put_word(word);
+
+      ++retval;
+   }
+
+   if (retval > 0) {
+      m_isUserDirty = true;
+
+      clearCache();
+      ++m_revision;
+   }
+
+   return retval;
+}
+
+bool SpellCheck::saveUserDict(QString &error)
+{
+   QStringList wordList;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (! m_isUserDirty) {
+         return true;
+      }
+
+      if (m_userFname.isEmpty()) {
+         error = "Unable to find User Dictionary " + m_userFname;
+         return false;
       }
 
-      QTextStream stream(&file);
-      stream << lookUp << "\n";
+      if (! m_isLoaded || ! m_isUserReadable) {
+         // the words already in the file are not known yet, try again later
+         return true;
+      }
+
+      wordList = m_userWords.toList();
+      m_isUserDirty = false;
+   }
+
+   std::sort(wordList.begin(), wordList.end());
+
+   QByteArray data;
+
+   for (const QString &word : wordList) {
+      data += word.toUtf8();
+      data += '\n';
+   }
+
+   // written to a temporary file and renamed, the old file is intact if this fails
+   QSaveFile file(m_userFname);
+
+   if (! file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || ! file.commit()) {
+      error = QObject::tr("Unable to save file %1:\n%2.").formatArgs(m_userFname, file.errorString());
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_isUserDirty = true;
+
+      return false;
+   }
+
+   return true;
+}
+
+static int compareWord(const char *a, int lengthA, const char *b, int lengthB)
+{
+   int retval = std::memcmp(a, b, std::min(lengthA, lengthB));
+
+   if (retval == 0) {
+      retval = lengthA - lengthB;
+   }
+
+   return retval;
+}
+
+bool SpellCheck::isAccepted(const char *word, int length) const
+{
+   if (m_wordList == nullptr) {
+      return false;
+   }
+
+   // binary search, no allocation
+   const WordList &list = *m_wordList;
+
+   quint32 low  = 0;
+   quint32 high = list.count;
+
+   while (low < high) {
+      quint32 mid = low + (high - low) / 2;
+
+      const char *item = list.text + list.offsets[mid];
+      int itemLength   = list.offsets[mid + 1] - list.offsets[mid];
+
+      int cmp = compareWord(item, itemLength, word, length);
+
+      if (cmp == 0) {
+         return true;
+      }
+
+      if (cmp < 0) {
+         low = mid + 1;
+      } else {
+         high = mid;
+      }
+   }
+
+   return false;
+}
+
+void SpellCheck::setWordList(const char *data, WordList &wordList)
+{
+   const WordListHeader *header = reinterpret_cast<const WordListHeader *>(data);
+
+   wordList.count   = header->count;
+   wordList.offsets = reinterpret_cast<const quint32 *>(data + sizeof(WordListHeader));
+   wordList.text    = reinterpret_cast<const char *>(wordList.offsets + wordList.count + 1);
+}
+
+std::shared_ptr<const SpellCheck::WordList> SpellCheck::loadWordList(const QString &dicFname, const QString &affFname) const
+{
+   std::shared_ptr<WordList> retval;
+
+   QFileInfo dicInfo(dicFname);
+   QFileInfo affInfo(affFname);
+
+   if (! dicInfo.exists() || ! affInfo.exists()) {
+      return retval;
+   }
+
+   retval = std::make_shared<WordList>();
+
+   WordListHeader header;
+   std::memset(&header, 0, sizeof(header));
+
+   header.magic       = WORDLIST_MAGIC;
+   header.version     = WORDLIST_VERSION;
+   header.dicSize     = dicInfo.size();
+   header.dicModified = dicInfo.lastModified().toMSecsSinceEpoch();
+   header.affSize     = affInfo.size();
+   header.affModified = affInfo.lastModified().toMSecsSinceEpoch();
+
+   QByteArray headerData(reinterpret_cast<const char *>(&header), sizeof(header));
+
+   QString cacheFname;
+
+   if (! m_cachePath.isEmpty()) {
+      cacheFname = m_cachePath + "/" + dicInfo.completeBaseName() + ".words";
+
+      if (mapWordList(cacheFname, headerData, *retval)) {
+         return retval;
+      }
+   }
+
+   retval->data = buildWordList(dicFname, affFname, headerData);
+
+   if (retval->data.isEmpty()) {
+      // dictionary could not be parsed, every word goes to hunspell
+      retval.reset();
+      return retval;
+   }
+
+   if (! cacheFname.isEmpty()) {
+      QSaveFile file(cacheFname);
+
+      if (file.open(QIODevice::WriteOnly)) {
+         file.write(retval->data);
+         file.commit();
+      }
+   }
+
+   setWordList(retval->data.constData(), *retval);
 
-      file.close();
+   return retval;
+}
+
+bool SpellCheck::mapWordList(const QString &fileName, const QByteArray &header, WordList &wordList)
+{
+   QFile *file = new QFile(fileName);
+
+   if (! file->open(QFile::ReadOnly) || file->size() < qint64(sizeof(WordListHeader))) {
+      delete file;
+      return false;
+   }
+
+   const char *data = reinterpret_cast<const char *>(file->map(0, file->size()));
+
+   // everything before the word count identifies the dictionary
+   const int keySize = offsetof(WordListHeader, count);
+
+   if (data == nullptr || std::memcmp(data, header.constData(), keySize) != 0) {
+      delete file;
+      return false;
+   }
+
+   const WordListHeader *item = reinterpret_cast<const WordListHeader *>(data);
+
+   qint64 size = sizeof(WordListHeader) + (qint64(item->count) + 1) * sizeof(quint32) + item->textSize;
+
+   if (size != file->size()) {
+      delete file;
+      return false;
+   }
+
+   wordList.file = file;
+   setWordList(data, wordList);
+
+   return true;
+}
+
+static QStringList splitFlags(const QString &flags, const QString &flagType)
+{
+   QStringList retval;
+
+   if (flagType == "long") {
+      for (int k = 0; k + 1 < flags.length(); k += 2) {
+         retval.append(flags.mid(k, 2));
+      }
+
+   } else if (flagType == "num") {
+      retval = flags.split(',');
 
    } else {
-      csError("Spell Check", "Unable to find User Dictionary " + m_userFname);
+      for (QChar c : flags) {
+         retval.append(QString(c));
+      }
+
+   }
+
+   return retval;
+}
 
+QByteArray SpellCheck::buildWordList(const QString &dicFname, const QString &affFname, const QByteArray &header)
+{
+   // a stem is accepted without hunspell unless it is only valid with an affix, only inside a
+   // compound, or forbidden
+
+   QByteArray retval;
+
+   QFile affFile(affFname);
+   QFile dicFile(dicFname);
+
+   if (! affFile.open(QFile::ReadOnly) || ! dicFile.open(QFile::ReadOnly)) {
+      return retval;
+   }
+
+   QByteArray affData = affFile.readAll();
+   QByteArray dicData = dicFile.readAll();
+
+   // encoding of both files
+   QByteArray encoding = "ISO8859-1";
+
+   for (const QByteArray &line : affData.split('\n')) {
+      if (line.startsWith("SET ")) {
+         encoding = line.mid(4).trimmed();
+         break;
+      }
+   }
+
+   if (encoding == "UTF8") {
+      encoding = "UTF-8";
+   }
+
+   QTextCodec *codec = QTextCodec::codecForName(encoding.constData());
+
+   if (codec == nullptr) {
+      return retval;
    }
+
+   QString flagType;
+   QStringList aliasList;
+   QSet<QString> excludeFlags;
+
+   // the AF count line, -1 until it has been read
+   int aliasCount = -1;
+
+   for (const QString &line : codec->toUnicode(affData).split('\n')) {
+      QStringList fieldList = line.simplified().split(' ');
+
+      if (fieldList.size() < 2) {
+         continue;
+      }
+
+      const QString &key = fieldList[0];
+
+      if (key == "FLAG") {
+         flagType = fieldList[1];
+
+      } else if (key == "AF") {
+         bool isCount;
+         int count = fieldList[1].toInt(&isCount);
+
+         if (aliasCount < 0 && isCount && fieldList.size() == 2) {
+            // count line, a numeric alias after it is kept even when it looks the same
+            aliasCount = count;
+
+         } else {
+            aliasList.append(fieldList[1]);
+
+         }
+
+      } else if (key == "NEEDAFFIX" || key == "PSEUDOROOT" || key == "ONLYINCOMPOUND" ||
+            key == "FORBIDDENWORD" || key == "SUBSTANDARD") {
+
+         excludeFlags.insert(fieldList[1]);
+      }
+   }
+
+   std::vector<QByteArray> wordList;
+   QSet<QByteArray> forbiddenList;
+
+   bool isFirst = true;
+
+   for (const QString &text : codec->toUnicode(dicData).split('\n')) {
+      QString line = text;
+
+      if (line.endsWith("\r")) {
+         line.chop(1);
+      }
+
+      if (isFirst) {
+         // word count
+         isFirst = false;
+         continue;
+      }
+
+      if (line.isEmpty() || line.startsWith("#") || line.startsWith("\t") || line.startsWith(" ")) {
+         continue;
+      }
+
+      // morphological fields follow a tab or a space
+      int index = line.indexOf('\t');
+
+      if (index >= 0) {
+         line = line.left(index);
+      }
+
+      index = line.indexOf(' ');
+
+      if (index >= 0) {
+         line = line.left(index);
+      }
+
+      // flags follow the first unescaped slash
+      QString word  = line;
+      QString flags;
+
+      index = 0;
+
+      while ((index = line.indexOf('/', index)) >= 0) {
+         if (index == 0 || line[index - 1] != '\\') {
+            word  = line.left(index);
+            flags = line.mid(index + 1);
+            break;
+         }
+
+         ++index;
+      }
+
+      word.replace("\\/", "/");
+
+      if (word.isEmpty()) {
+         continue;
+      }
+
+      if (! aliasList.isEmpty() && ! flags.isEmpty()) {
+         flags = aliasList.value(flags.toInt() - 1);
+      }
+
+      bool isExcluded = false;
+
+      if (! flags.isEmpty() && ! excludeFlags.isEmpty()) {
+         for (const QString &flag : splitFlags(flags, flagType)) {
+            if (excludeFlags.contains(flag)) {
+               isExcluded = true;
+            }
+         }
+      }
+
+      QByteArray data = word.toUtf8();
+
+      if (isExcluded) {
+         // also drops a homonym without the flag, hunspell still accepts that one
+         forbiddenList.insert(data);
+         continue;
+      }
+
+      if (data.size() > 0xffff) {
+         continue;
+      }
+
+      wordList.push_back(data);
+   }
+
+   auto lessThan = [] (const QByteArray &a, const QByteArray &b) {
+      return compareWord(a.constData(), a.size(), b.constData(), b.size()) < 0;
+   };
+
+   std::sort(wordList.begin(), wordList.end(), lessThan);
+   wordList.erase(std::unique(wordList.begin(), wordList.end()), wordList.end());
+
+   if (! forbiddenList.isEmpty()) {
+      wordList.erase(std::remove_if(wordList.begin(), wordList.end(),
+            [&forbiddenList] (const QByteArray &item) { return forbiddenList.contains(item); } ), wordList.end());
+   }
+
+   // header, offsets, text
+   QByteArray text;
+   std::vector<quint32> offsetList;
+
+   offsetList.reserve(wordList.size() + 1);
+
+   for (const QByteArray &item : wordList) {
+      offsetList.push_back(text.size());
+      text.append(item);
+   }
+
+   offsetList.push_back(text.size());
+
+   retval = header;
+
+   WordListHeader *item = reinterpret_cast<WordListHeader *>(retval.data());
+   item->count    = wordList.size();
+   item->textSize = text.size();
+
+   retval.append(reinterpret_cast<const char *>(offsetList.data()), offsetList.size() * sizeof(quint32));
+   retval.append(text);
+
+   return retval;
 }
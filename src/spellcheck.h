@@ -15,9 +15,21 @@
 #ifndef SPELLCHECK_H
 #define SPELLCHECK_H
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
 #include <QString>
+#include <QStringList>
 
 class Hunspell;
+class QFile;
 
 class SpellCheck
 {
@@ -25,18 +37,149 @@ class SpellCheck
       SpellCheck(const QString &dictMain, const QString &dictUser);
       ~SpellCheck();
 
+      // folder for the cached word list of the main dictionary, set before load()
+      void setCachePath(const QString &path);
+
+      // dictionaries are read on a background thread the first time this is called,
+      // until then every word is correct and there are no suggestions
+      void load();
+      bool isLoaded() const;
+
+      // set when the user dictionary could not be read, checked once loaded
+      QString loadError() const;
+
       bool spell(QStringView word);
-      QStringList suggest(const QString &word);
+
+      // returns false and queues the word for the suggest thread when the suggestions are not cached
+      bool suggestCached(const QString &word, QStringList &list);
       void ignoreWord(const QString &word);
+
+      // words are kept in memory, call saveUserDict() a short time after the last change
       void addToUserDict(const QString &word);
 
+      // project word list with one word per line, returns the number of new words or -1
+      int importUserDict(const QString &fileName, QString &error);
+
+      // writes the whole user dictionary if it changed, the file is replaced atomically
+      bool saveUserDict(QString &error);
+
+      // changes when words are added, cached spell results older than this are stale
+      int revision() const;
+
+      // separate checker with the same dictionaries and ignored words, loaded on the calling thread
+      // each thread of the spell check report uses its own so they do not share one hunspell
+      SpellCheck *clone();
+
+      // reuses a clone given back by releaseClone() and adds the words added since, only a new clone
+      // loads the dictionary
+      SpellCheck *takeClone();
+      void releaseClone(SpellCheck *spellCheck);
+
    private:
+      QString m_mainFname;
       QString m_userFname;
       QTextCodec *m_codec;
 
       Hunspell *m_hunspell;
 
+      std::thread m_loadThread;
+      std::atomic<bool> m_isLoaded;
+      bool m_isLoading;
+
+      QString m_loadError;
+
+      // words added before the dictionary was ready
+      QStringList m_pendingList;
+
+      // ignored for this session only, copied to clones
+      QStringList m_ignoreList;
+
+      // user dictionary, sorted when saved
+      QSet<QString> m_userWords;
+      bool m_isUserDirty;
+      bool m_isUserReadable;
+
+      // utf-8 of the user and ignored words given to hunspell, checked before hunspell
+      QSet<QByteArray> m_addedWords;
+
+      // clones have no user dictionary file
+      bool m_isClone;
+
+      // every word given to hunspell in order, a clone in the pool has the first m_wordLogCount
+      QStringList m_wordLog;
+      int m_wordLogCount;
+
+      std::mutex m_poolMutex;
+      std::vector<SpellCheck *> m_clonePool;
+
+      void loadDictionary();
+      void dictFiles(QString &dicFname, QString &affFname) const;
+
+      // stems of the main dictionary which need no affix, checked before hunspell
+      // sorted by their utf-8 bytes, either mapped from the cache file or built in memory
+      struct WordList
+      {
+         WordList();
+         ~WordList();
+
+         QFile *file;
+         QByteArray data;
+
+         const quint32 *offsets;
+         const char *text;
+         quint32 count;
+      };
+
+      QString m_cachePath;
+
+      // built or mapped once, clones share it read only
+      std::shared_ptr<const WordList> m_wordList;
+
+      std::shared_ptr<const WordList> loadWordList(const QString &dicFname, const QString &affFname) const;
+      static bool mapWordList(const QString &fileName, const QByteArray &header, WordList &wordList);
+      static void setWordList(const char *data, WordList &wordList);
+      bool isAccepted(const char *word, int length) const;
+
+      static QByteArray buildWordList(const QString &dicFname, const QString &affFname, const QByteArray &header);
+
+      // hunspell is not thread safe, the syntax worker calls spell() as well
+      // the verdict cache has its own lock so a hit does not wait for a miss
+      std::mutex m_mutex;
+      std::mutex m_cacheMutex;
+      std::atomic<int> m_revision;
+
+      // verdicts of recently checked words, direct mapped on a hash of the utf-8 bytes
+      static constexpr int CACHE_WORD_SIZE = 27;
+
+      struct SpellEntry
+      {
+         uint hash;
+         bool isUsed;
+         bool isCorrect;
+         char length;
+         char word[CACHE_WORD_SIZE];
+      };
+
+      std::vector<SpellEntry> m_cache;
+
+      void clearCache();
       void put_word(const QString &word);
+
+      // suggestions for the context menu, cached per word until a word is added
+      std::thread m_suggestThread;
+      std::mutex m_suggestMutex;
+      std::condition_variable m_suggestCondition;
+
+      QString m_suggestWord;
+      QHash<QString, QStringList> m_suggestList;
+      bool m_stop;
+
+      // words added after the suggest thread copied the word lists, applied to its own hunspell
+      QStringList m_suggestAdded;
+      bool m_isSuggestReady;
+
+      void suggestLoop();
+      QStringList suggest(Hunspell *hunspell, const QString &word);
 };
 
 #endif
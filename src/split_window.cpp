@@ -304,6 +304,11 @@ void MainWindow::split_NameChanged(int data)
       DiamondTextEdit *textEdit = dynamic_cast<DiamondTextEdit *>(temp);
 
       if (textEdit) {
+
+         if (textEdit->get_IsStub()) {
+            tab_Load(textEdit, m_tabWidget->tabWhatsThis(whichTab));
+         }
+
          // get document matching the file name
          m_split_textEdit->setDocument(textEdit->document());
 
@@ -15,21 +15,94 @@
 #include "dialog_buffer.h"
 #include "dialog_getline.h"
 #include "dialog_xp_getdir.h"
+#include "file_loader.h"
 #include "mainwindow.h"
 
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <QBoxLayout>
+#include <QDateTime>
 #include <QFileInfo>
 #include <QFileDialog>
 #include <QFSFileEngine>
 #include <QDragEnterEvent>
+#include <QElapsedTimer>
+#include <QLabel>
 #include <QMimeData>
+#include <QProgressBar>
+#include <QSaveFile>
 #include <QSysInfo>
+#include <QTextBlock>
+#include <QTextCursor>
 #include <QUrl>
 
+#if defined (Q_OS_UNIX)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// bytes read at a time when loading a file, the document grows by one chunk at a time
+static const qint64 LOAD_CHUNK_SIZE = 4 * 1024 * 1024;
+
+// larger files are opened on a worker thread
+static const qint64 ASYNC_LOAD_SIZE = 16 * 1024 * 1024;
+
+// bytes encoded before each write when saving a file
+static const int SAVE_CHUNK_SIZE = 1024 * 1024;
+
+// milliseconds of each timer tick spent adding text to documents which are loading
+static const int LOAD_SLICE_TIME = 20;
+
+static bool readDocument(QFile &file, QTextDocument *document)
+{
+   // peak memory is the document plus one chunk, the whole file is never held as bytes or as a string
+   LoadDecoder decoder;
+
+   // loaded text is not undoable, same as setPlainText()
+   document->setUndoRedoEnabled(false);
+   document->clear();
+
+   QTextCursor cursor(document);
+
+   QByteArray buffer;
+   buffer.resize(LOAD_CHUNK_SIZE);
+
+   bool retval = true;
+
+   while (true) {
+      qint64 size = file.read(buffer.data(), LOAD_CHUNK_SIZE);
+
+      if (size < 0) {
+         retval = false;
+         break;
+      }
+
+      if (size == 0) {
+         break;
+      }
+
+      cursor.insertText(decoder.decode(buffer.data(), size));
+   }
+
+   cursor.insertText(decoder.finish());
+
+   document->setUndoRedoEnabled(true);
+
+   // a file which was only partly read is not the same as the one on disk
+   document->setModified(! retval);
+
+   return retval;
+}
+
 void MainWindow::argLoad(QList<QString> argList)
 {
    int argCnt = argList.count();
 
    QStringList t_openedFiles = m_openedFiles;
+   QStringList loadList;
 
    if (m_args.flag_noAutoLoad) {
       t_openedFiles.clear();
@@ -51,30 +124,29 @@ void MainWindow::argLoad(QList<QString> argList)
       } else if (t_openedFiles.contains(tempFile, Qt::CaseInsensitive) ) {
          // file is already open
 
+      } else if (loadList.contains(tempFile, Qt::CaseInsensitive) ) {
+         // file was already passed
+
       } else if ( QFile::exists(tempFile) ) {
-         if (loadFile(tempFile, true, true)) {
-            t_openedFiles.append(tempFile);
-         }
+         loadList.append(tempFile);
       }
    }
+
+   // only files which loaded are open
+   t_openedFiles.append(loadFiles(loadList, true));
 }
 
 void MainWindow::autoLoad()
 {
-   QString fileName;
    int count = m_openedFiles.size();
 
    if (count == 0) {
       tabNew();
 
    } else {
+      // load existing files
+      loadFiles(m_openedFiles, true);
 
-      for (int k = 0; k < count; k++)  {
-         fileName = m_openedFiles.at(k);
-
-         // load existing files
-         loadFile(fileName, true, true);
-      }
    }
 }
 
@@ -84,6 +156,14 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
    if (exit) {
       json_Write(CLOSE);
+
+      if (m_spellReport != nullptr) {
+         // stops the report threads
+         spell_ReportStop();
+      }
+
+      m_userDictTimer->stop();
+      spell_SaveUserDict();
       event->accept();
 
    } else {
@@ -211,45 +291,19 @@ bool MainWindow::loadFile(QString fileName, bool addNewTab, bool isAuto, bool is
 
    // part 1
    if (addNewTab)  {
-      // test if fileName is open in another tab
-      QFSFileEngine engine(fileName);
-
-      int count = m_tabWidget->count();
-
-      QWidget *temp;
-      DiamondTextEdit *textEdit;
-
-      for (int k = 0; k < count; ++k) {
-
-         temp = m_tabWidget->widget(k);
-         textEdit = dynamic_cast<DiamondTextEdit *>(temp);
+      int index = loadFile_FindTab(fileName);
 
-         if (textEdit) {
-            QString t_Fname = m_tabWidget->tabWhatsThis(k);
-            bool found      = false;
-
-            if (engine.caseSensitive()) {
-               found = (fileName == t_Fname);
-
-            } else {
-               // usually only windows
-               found = fileName.compare(t_Fname, Qt::CaseInsensitive) == 0;
-
-            }
-
-            if (found) {
-               // file is alredy open, select the tab
-               m_textEdit = textEdit;
-               m_tabWidget->setCurrentIndex(k);
-               return true;
-            }
-         }
+      if (index >= 0) {
+         // file is alredy open, select the tab
+         m_textEdit = dynamic_cast<DiamondTextEdit *>(m_tabWidget->widget(index));
+         m_tabWidget->setCurrentIndex(index);
+         return true;
       }
    }
 
    QFile file(fileName);
 
-   if (! file.open(QFile::ReadOnly | QFile::Text)) {
+   if (! file.open(QFile::ReadOnly)) {
 
       if (! isAuto) {
          // do not show this message
@@ -265,11 +319,24 @@ bool MainWindow::loadFile(QString fileName, bool addNewTab, bool isAuto, bool is
       }
    }
 
+   if (addNewTab && file.size() > ASYNC_LOAD_SIZE) {
+      // read on a worker thread, the tab fills in while the other tabs stay usable
+      qint64 fileSize = file.size();
+      file.close();
+
+      loadFile_Async(fileName, fileSize, isAuto);
+      return true;
+   }
+
+   if (! addNewTab) {
+      // reload of a tab which is still loading
+      loadFile_Stop(m_textEdit);
+   }
+
    setStatusBar(tr("Loading File..."), 0);
    QApplication::setOverrideCursor(Qt::WaitCursor);
 
    file.seek(0);
-   QByteArray temp = file.readAll();
 
    if (addNewTab) {
       tabNew();
@@ -281,10 +348,469 @@ bool MainWindow::loadFile(QString fileName, bool addNewTab, bool isAuto, bool is
       }
    }
 
-   QString fileData = QString::fromUtf8(temp);
-   m_textEdit->setPlainText(fileData);
+   bool isRead = readDocument(file, m_textEdit->document());
+   m_textEdit->moveCursor(QTextCursor::Start);
+
    QApplication::restoreOverrideCursor();
 
+   if (! isRead && ! isAuto) {
+      QString error = tr("Unable to read file:  %1\n%2.").formatArgs(fileName, file.errorString());
+      csError(tr("Open/Read File"), error);
+   }
+
+   loadFile_Done(fileName, addNewTab, isAuto, isReload);
+
+   return true;
+}
+
+int MainWindow::loadFile_FindTab(const QString &fileName)
+{
+   // test if fileName is open in another tab
+   QFSFileEngine engine(fileName);
+
+   int count = m_tabWidget->count();
+
+   QWidget *temp;
+   DiamondTextEdit *textEdit;
+
+   for (int k = 0; k < count; ++k) {
+
+      temp = m_tabWidget->widget(k);
+      textEdit = dynamic_cast<DiamondTextEdit *>(temp);
+
+      if (textEdit) {
+         QString t_Fname = m_tabWidget->tabWhatsThis(k);
+         bool found      = false;
+
+         if (engine.caseSensitive()) {
+            found = (fileName == t_Fname);
+
+         } else {
+            // usually only windows
+            found = fileName.compare(t_Fname, Qt::CaseInsensitive) == 0;
+
+         }
+
+         if (found) {
+            return k;
+         }
+      }
+   }
+
+   return -1;
+}
+
+static bool isReplaceable(const QString &fileName)
+{
+   // a new file renamed over the original would split a hard link and give the file to the user saving it
+#if defined (Q_OS_UNIX)
+   struct stat info;
+
+   if (::stat(QFile::encodeName(fileName).constData(), &info) != 0) {
+      return true;
+   }
+
+   if (info.st_nlink > 1 || info.st_uid != ::geteuid() || info.st_gid != ::getegid()) {
+      return false;
+   }
+#endif
+
+   return true;
+}
+
+static bool writeDocument(QFileDevice &file, QTextDocument *document)
+{
+   // blocks are encoded one at a time, the whole document is never copied as a string or as bytes
+#if defined (Q_OS_WIN)
+   // same line breaks a text mode file would write
+   const QByteArray lineBreak = "\r\n";
+#else
+   const QByteArray lineBreak = "\n";
+#endif
+
+   QByteArray buffer;
+   buffer.reserve(SAVE_CHUNK_SIZE + 4096);
+
+   for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+      QString text = block.text();
+
+      // same characters toPlainText() replaces
+      text.replace(QChar(char32_t(0x00A0)), QChar(' '));
+      text.replace(QChar(char32_t(0x2028)), QChar('\n'));
+      text.replace(QChar(char32_t(0x2029)), QChar('\n'));
+
+      buffer.append(text.toUtf8());
+
+      if (block.next().isValid()) {
+         buffer.append(lineBreak);
+      }
+
+      if (buffer.size() >= SAVE_CHUNK_SIZE) {
+         if (file.write(buffer) != buffer.size()) {
+            return false;
+         }
+
+         buffer.clear();
+      }
+   }
+
+   if (! buffer.isEmpty() && file.write(buffer) != buffer.size()) {
+      return false;
+   }
+
+   return true;
+}
+
+static QString readText(const QString &fileName, QString &error)
+{
+   // runs on a worker thread, only used for files below the background load size
+   QString retval;
+   QFile file(fileName);
+
+   if (! file.open(QFile::ReadOnly)) {
+      error = file.errorString();
+      return retval;
+   }
+
+   // decoded one chunk at a time, the whole file is never held as bytes
+   LoadDecoder decoder;
+
+   QByteArray buffer;
+   buffer.resize(std::min(LOAD_CHUNK_SIZE, file.size() + 1));
+
+   while (true) {
+      qint64 size = file.read(buffer.data(), buffer.size());
+
+      if (size < 0) {
+         error = file.errorString();
+         return QString();
+      }
+
+      if (size == 0) {
+         break;
+      }
+
+      retval += decoder.decode(buffer.data(), size);
+   }
+
+   retval += decoder.finish();
+
+   return retval;
+}
+
+QStringList MainWindow::loadFiles(QStringList fileList, bool isAuto)
+{
+   // files are read in parallel, tabs are created in order and syntax is set up when a tab is first shown
+   QStringList retval;
+
+   QStringList nameList;
+   QList<qint64> sizeList;
+
+   for (QString fileName : fileList) {
+
+#if defined (Q_OS_WIN)
+      // change forward to backslash
+      fileName.replace('/', '\\');
+#endif
+
+      if (fileName.isEmpty() || nameList.contains(fileName)) {
+         continue;
+      }
+
+      int index = loadFile_FindTab(fileName);
+
+      if (index >= 0) {
+         // file is alredy open, select the tab
+         m_tabWidget->setCurrentIndex(index);
+         continue;
+      }
+
+      QFileInfo info(fileName);
+
+      if (! info.exists()) {
+
+         if (! isAuto) {
+            csError(tr("Open/Read File"), tr("Unable to open/read file:  %1").formatArg(fileName));
+         }
+
+         continue;
+      }
+
+      nameList.append(fileName);
+      sizeList.append(info.size());
+   }
+
+   int cnt = nameList.size();
+
+   if (cnt == 0) {
+      return retval;
+   }
+
+   // the last file is the one showing, with lazy loading the others are read when first shown
+   std::vector<bool> stubList(cnt, false);
+
+   if (m_struct.tabLazyLoad) {
+      for (int k = 0; k < cnt - 1; ++k) {
+         stubList[k] = true;
+      }
+   }
+
+   std::vector<QString> textList(cnt);
+   std::vector<QString> errorList(cnt);
+
+   {
+      int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+      threads = std::min(threads, cnt);
+
+      std::vector<std::future<void>> futureList;
+
+      for (int t = 0; t < threads; ++t) {
+         futureList.push_back(std::async(std::launch::async, [&, t] () {
+
+            for (int k = t; k < cnt; k += threads) {
+               if (! stubList[k] && sizeList.at(k) <= ASYNC_LOAD_SIZE) {
+                  textList[k] = readText(nameList.at(k), errorList[k]);
+               }
+            }
+         } ));
+      }
+
+      for (auto &item : futureList) {
+         item.get();
+      }
+   }
+
+   bool isRecentChanged = false;
+
+   for (int k = 0; k < cnt; ++k) {
+      const QString &fileName = nameList[k];
+
+      if (! stubList[k] && sizeList[k] > ASYNC_LOAD_SIZE) {
+         loadFile_Async(fileName, sizeList[k], isAuto);
+         retval.append(fileName);
+
+         continue;
+      }
+
+      if (! errorList[k].isEmpty()) {
+
+         if (! isAuto) {
+            QString error = tr("Unable to open/read file:  %1\n%2.").formatArgs(fileName, errorList[k]);
+            csError(tr("Open/Read File"), error);
+         }
+
+         continue;
+      }
+
+      tabNew();
+
+      // the empty tab was given plain text highlighting, the real syntax is set up later
+      releaseSyntax(m_textEdit);
+
+      if (stubList[k]) {
+         // only the name until the tab is shown
+         m_textEdit->set_IsStub(true);
+
+      } else {
+         QTextDocument *document = m_textEdit->document();
+
+         // loaded text is not undoable, same as setPlainText()
+         document->setUndoRedoEnabled(false);
+         QTextCursor(document).insertText(textList[k]);
+         document->setUndoRedoEnabled(true);
+
+         document->setModified(false);
+         m_textEdit->moveCursor(QTextCursor::Start);
+
+         textList[k] = QString();
+
+         m_syntaxPending.insert(m_textEdit);
+      }
+
+      int index = m_tabWidget->currentIndex();
+
+      m_tabWidget->setTabText(index, strippedName(fileName));
+      m_tabWidget->setTabWhatsThis(index, fileName);
+
+      m_curFile = fileName;
+
+      if (! m_rf_List.contains(fileName)) {
+
+         if (m_rf_List.count() >= RECENT_FILES_MAX) {
+            m_rf_List.removeFirst();
+         }
+
+         m_rf_List.append(fileName);
+         isRecentChanged = true;
+      }
+
+      if (m_isSplit) {
+         // update split combo box
+         add_splitCombo(fileName);
+      }
+
+      if (! isAuto)  {
+         // update open tab list
+         openTab_Add();
+      }
+
+      retval.append(fileName);
+   }
+
+   if (retval.isEmpty()) {
+      return retval;
+   }
+
+   // configuration is written once for the whole batch
+   m_struct.pathPrior = this->pathName(retval.last());
+
+   if (! isAuto) {
+      json_Write(PATH_PRIOR);
+   }
+
+   if (isRecentChanged) {
+      json_Write(RECENTFILE);
+      rf_UpdateActions();
+   }
+
+   // the last tab is showing, its syntax is set now
+   tabChanged(m_tabWidget->currentIndex());
+
+   setStatusBar(tr("Files loaded"), 1500);
+
+   return retval;
+}
+
+static qint64 tabMemory(DiamondTextEdit *textEdit)
+{
+   // rough estimate of the text, block and layout data held by the document
+   QTextDocument *document = textEdit->document();
+
+   return qint64(document->characterCount()) * 3 + qint64(document->blockCount()) * 200;
+}
+
+void MainWindow::tab_Load(DiamondTextEdit *textEdit, const QString &fileName)
+{
+   // stub shown for the first time, the text is read now
+   textEdit->set_IsStub(false);
+
+   QFile file(fileName);
+
+   if (! file.open(QFile::ReadOnly)) {
+      QString error = tr("Unable to open/read file:  %1\n%2.").formatArgs(fileName, file.errorString());
+      csError(tr("Open/Read File"), error);
+      return;
+   }
+
+   if (file.size() > ASYNC_LOAD_SIZE) {
+      qint64 fileSize = file.size();
+      file.close();
+
+      loadFile_Worker(textEdit, fileName, fileSize, true);
+      return;
+   }
+
+   QApplication::setOverrideCursor(Qt::WaitCursor);
+
+   bool isRead = readDocument(file, textEdit->document());
+
+   // back to where the cursor was when the tab was unloaded
+   QTextCursor cursor(textEdit->document());
+   cursor.setPosition(std::min(textEdit->get_StubPosition(), textEdit->document()->characterCount() - 1));
+   textEdit->setTextCursor(cursor);
+
+   QApplication::restoreOverrideCursor();
+
+   if (! isRead) {
+      QString error = tr("Unable to read file:  %1\n%2.").formatArgs(fileName, file.errorString());
+      csError(tr("Open/Read File"), error);
+   }
+
+   m_syntaxPending.insert(textEdit);
+}
+
+void MainWindow::tab_Unload(DiamondTextEdit *textEdit)
+{
+   textEdit->set_StubPosition(textEdit->textCursor().position());
+
+   releaseSyntax(textEdit);
+
+   // also drops the undo stack
+   textEdit->document()->clear();
+   textEdit->document()->setModified(false);
+
+   textEdit->set_IsStub(true);
+}
+
+QString MainWindow::tab_Text(DiamondTextEdit *textEdit, const QString &fileName)
+{
+   if (! textEdit->get_IsStub()) {
+      return textEdit->toPlainText();
+   }
+
+   QString error;
+   return readText(fileName, error);
+}
+
+void MainWindow::tab_CheckMemory()
+{
+   // unmodified tabs which are not showing can go back to a stub, the file is read again when shown
+   qint64 now     = QDateTime::currentMSecsSinceEpoch();
+   qint64 idle    = qint64(m_struct.tabUnloadMinutes) * 60 * 1000;
+   qint64 maxSize = qint64(m_struct.tabMemoryCap) * 1024 * 1024;
+
+   qint64 totalSize = 0;
+   QList<DiamondTextEdit *> candidateList;
+
+   int count   = m_tabWidget->count();
+   int current = m_tabWidget->currentIndex();
+
+   // the tab showing is in use
+   m_textEdit->set_LastUsed(now);
+
+   for (int k = 0; k < count; ++k) {
+      DiamondTextEdit *textEdit = dynamic_cast<DiamondTextEdit *>(m_tabWidget->widget(k));
+
+      if (textEdit == nullptr || textEdit->get_IsStub()) {
+         continue;
+      }
+
+      totalSize += tabMemory(textEdit);
+
+      if (k == current || textEdit->document()->isModified() || get_curFileName(k).isEmpty()) {
+         continue;
+      }
+
+      if (loadFile_IsLoading(textEdit)) {
+         continue;
+      }
+
+      if (m_isSplit && m_split_textEdit->document() == textEdit->document()) {
+         continue;
+      }
+
+      candidateList.append(textEdit);
+   }
+
+   // least recently used first
+   std::sort(candidateList.begin(), candidateList.end(), [] (DiamondTextEdit *a, DiamondTextEdit *b)
+         { return a->get_LastUsed() < b->get_LastUsed(); } );
+
+   for (DiamondTextEdit *textEdit : candidateList) {
+      bool isIdle = idle > 0 && now - textEdit->get_LastUsed() > idle;
+      bool isOver = maxSize > 0 && totalSize > maxSize;
+
+      if (! isIdle && ! isOver) {
+         continue;
+      }
+
+      totalSize -= tabMemory(textEdit);
+      tab_Unload(textEdit);
+   }
+}
+
+void MainWindow::loadFile_Done(const QString &fileName, bool addNewTab, bool isAuto, bool isReload)
+{
    if (m_textEdit->m_owner == "tab") {
       setCurrentTitle(fileName, false, isReload);
    }
@@ -310,8 +836,224 @@ bool MainWindow::loadFile(QString fileName, bool addNewTab, bool isAuto, bool is
    }
 
    setStatusBar(tr("File loaded"), 1500);
+}
 
-   return true;
+void MainWindow::loadFile_Async(const QString &fileName, qint64 fileSize, bool isAuto)
+{
+   tabNew();
+
+   m_struct.pathPrior = this->pathName(fileName);
+
+   if (! isAuto) {
+      json_Write(PATH_PRIOR);
+   }
+
+   // name the tab now so the file is found as already open, syntax is set once loaded
+   setCurrentTitle(fileName, true);
+
+   loadFile_Worker(m_textEdit, fileName, fileSize, isAuto);
+}
+
+void MainWindow::loadFile_Worker(DiamondTextEdit *textEdit, const QString &fileName, qint64 fileSize, bool isAuto)
+{
+   // the empty tab was given plain text highlighting, the real syntax is set up once loaded
+   releaseSyntax(textEdit);
+
+   textEdit->setReadOnly(true);
+   textEdit->document()->setUndoRedoEnabled(false);
+
+   loadFileStruct job;
+
+   job.textEdit = textEdit;
+   job.fileName = fileName;
+   job.isAuto   = isAuto;
+   job.cursor   = QTextCursor(textEdit->document());
+   job.loader   = new FileLoader(fileName, fileSize);
+
+   // placeholder shown over the editor until the whole file is in the document
+   job.progressWidget = new QFrame(textEdit);
+   job.progressWidget->setFrameShape(QFrame::Panel);
+   job.progressWidget->setAutoFillBackground(true);
+
+   QLabel *label = new QLabel();
+   label->setText(tr("Loading %1").formatArg(strippedName(fileName)));
+
+   job.progressBar = new QProgressBar();
+   job.progressBar->setRange(0, 100);
+   job.progressBar->setValue(0);
+
+   QPushButton *cancelButton = new QPushButton();
+   cancelButton->setText(tr("Cancel"));
+
+   QBoxLayout *layout = new QHBoxLayout();
+   layout->addWidget(label);
+   layout->addWidget(job.progressBar);
+   layout->addWidget(cancelButton);
+
+   job.progressWidget->setLayout(layout);
+   job.progressWidget->adjustSize();
+   job.progressWidget->move(20, 20);
+   job.progressWidget->show();
+
+   connect(cancelButton, &QPushButton::clicked, this, [this, textEdit] () { loadFile_Cancel(textEdit); } );
+
+   job.loader->start();
+   m_loadList.append(job);
+
+   m_loadTimer->start();
+   setStatusBar(tr("Loading File..."), 0);
+}
+
+void MainWindow::loadFile_Slice()
+{
+   // text is moved into the documents a slice at a time so the GUI thread stays responsive
+   QElapsedTimer timer;
+   timer.start();
+
+   int k = 0;
+
+   while (k < m_loadList.size()) {
+      loadFileStruct &job = m_loadList[k];
+
+      QString text;
+
+      while (timer.elapsed() < LOAD_SLICE_TIME && job.loader->takeText(text)) {
+         bool isFirst = job.cursor.position() == 0;
+
+         job.cursor.insertText(text);
+
+         if (isFirst) {
+            // the first insert moved the view to the end
+            job.textEdit->moveCursor(QTextCursor::Start);
+         }
+      }
+
+      job.textEdit->document()->setModified(false);
+
+      if (job.loader->fileSize() > 0) {
+         job.progressBar->setValue(job.loader->bytesRead() * 100 / job.loader->fileSize());
+      }
+
+      if (job.loader->isDone()) {
+         loadFile_Finish(k);
+      } else {
+         ++k;
+      }
+   }
+
+   if (m_loadList.isEmpty()) {
+      m_loadTimer->stop();
+   }
+}
+
+void MainWindow::loadFile_Finish(int index)
+{
+   loadFileStruct job = m_loadList.takeAt(index);
+   QString error = job.loader->errorString();
+
+   delete job.loader;
+   delete job.progressWidget;
+
+   QTextDocument *document = job.textEdit->document();
+   document->setUndoRedoEnabled(true);
+
+   // a file which was only partly read is not the same as the one on disk
+   document->setModified(! error.isEmpty());
+
+   job.textEdit->setReadOnly(false);
+
+   // finish on the loaded tab, the tab the user is looking at is selected again afterwards
+   int tabIndex = m_tabWidget->indexOf(job.textEdit);
+   int current  = m_tabWidget->currentIndex();
+
+   if (tabIndex != current) {
+      m_tabWidget->setCurrentIndex(tabIndex);
+   }
+
+   loadFile_Done(job.fileName, true, job.isAuto, false);
+
+   if (tabIndex != current) {
+      m_tabWidget->setCurrentIndex(current);
+   }
+
+   if (! error.isEmpty()) {
+      QString msg = tr("Unable to read file:  %1\n%2.").formatArgs(job.fileName, error);
+      csError(tr("Open/Read File"), msg);
+   }
+}
+
+bool MainWindow::loadFile_Stop(DiamondTextEdit *textEdit)
+{
+   for (int k = 0; k < m_loadList.size(); ++k) {
+
+      if (m_loadList[k].textEdit == textEdit) {
+         loadFileStruct job = m_loadList.takeAt(k);
+
+         // joins the worker thread
+         delete job.loader;
+
+         // may be called from the cancel button
+         job.progressWidget->deleteLater();
+
+         QTextDocument *document = textEdit->document();
+         document->setUndoRedoEnabled(true);
+         document->setModified(false);
+
+         textEdit->setReadOnly(false);
+
+         if (m_loadList.isEmpty()) {
+            m_loadTimer->stop();
+         }
+
+         return true;
+      }
+   }
+
+   return false;
+}
+
+bool MainWindow::loadFile_IsLoading(DiamondTextEdit *textEdit) const
+{
+   for (const auto &job : m_loadList) {
+      if (job.textEdit == textEdit) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void MainWindow::loadFile_Cancel(DiamondTextEdit *textEdit)
+{
+   if (! loadFile_Stop(textEdit)) {
+      return;
+   }
+
+   int index = m_tabWidget->indexOf(textEdit);
+
+   if (index < 0) {
+      return;
+   }
+
+   // same bookkeeping as tabClose(), a stub which was loading is already in the open tab list
+   m_tabWidget->setCurrentIndex(index);
+
+   m_textEdit = textEdit;
+   m_curFile  = this->get_curFileName(index);
+
+   m_syntaxPending.remove(textEdit);
+
+   // the document is not modified, nothing is asked
+   close_Doc();
+
+   if (m_tabWidget->count() > 1) {
+      m_tabWidget->removeTab(index);
+
+      // the cancel button belongs to this editor
+      textEdit->deleteLater();
+   }
+
+   setStatusBar(tr("Loading canceled"), 1500);
 }
 
 QString MainWindow::pathName(QString fileName) const
@@ -371,9 +1113,25 @@ bool MainWindow::saveFile(QString fileName, SaveFiles saveType)
    fileName.replace('/', '\\');
 #endif
 
-   QFile file(fileName);
+   if (loadFile_IsLoading(m_textEdit)) {
+      // saving now would truncate the file
+      csError(tr("Save/Write File"), tr("File is still loading, unable to save %1").formatArg(fileName));
+      return false;
+   }
+
+   // written to a temporary file in the same folder, which replaces the original only once complete
+   // a hard linked file or one owned by someone else is written in place, as is a file in a folder
+   // which is not writable
+   bool isAtomic = isReplaceable(fileName);
+
+   QSaveFile saveFile(fileName);
+   saveFile.setDirectWriteFallback(true);
 
-   if (! file.open(QFile::WriteOnly | QFile::Text)) {
+   QFile directFile(fileName);
+
+   QFileDevice &file = isAtomic ? static_cast<QFileDevice &>(saveFile) : directFile;
+
+   if (! file.open(QFile::WriteOnly)) {
 
       QString tmp = fileName;
       if (tmp.isEmpty()) {
@@ -389,10 +1147,43 @@ bool MainWindow::saveFile(QString fileName, SaveFiles saveType)
       deleteEOL_Spaces();
    }
 
+   QFileInfo info(fileName);
+
+   if (isAtomic && info.exists()) {
+      file.setPermissions(info.permissions());
+   }
+
    QApplication::setOverrideCursor(Qt::WaitCursor);
-   file.write(m_textEdit->toPlainText().toUtf8());
+
+   bool isSaved = writeDocument(file, m_textEdit->document());
+   QString errorMsg;
+
+   if (! isAtomic) {
+      // the original is truncated, an error here leaves it partly written
+      isSaved  = isSaved && file.flush();
+      errorMsg = file.errorString();
+      file.close();
+
+   } else if (isSaved) {
+      // flushed to disk and renamed over the original
+      isSaved  = saveFile.commit();
+      errorMsg = saveFile.errorString();
+
+   } else {
+      // the temporary file is removed, the original is left as it was
+      errorMsg = saveFile.errorString();
+      saveFile.cancelWriting();
+
+   }
+
    QApplication::restoreOverrideCursor();
 
+   if (! isSaved) {
+      QString error = tr("Unable to save/write file %1:\n%2.").formatArgs(fileName, errorMsg);
+      csError(tr("Save/Write File"), error);
+      return false;
+   }
+
    m_textEdit->document()->setModified(false);
 
    int index = m_openedFiles.indexOf(fileName);
@@ -505,6 +1296,35 @@ void MainWindow::setStatus_ColMode()
    m_textEdit->set_ColumnMode(m_struct.isColumnMode);
 }
 
+void MainWindow::setStatus_SyntaxMode()
+{
+   Syntax *parser = m_textEdit->get_SyntaxParser();
+   SyntaxMode mode = parser ? parser->get_Mode() : SYNTAX_NONE;
+
+   QString text;
+
+   switch (mode) {
+      case SYNTAX_KEYWORDS:
+         text = " Keywords Only";
+         break;
+
+      case SYNTAX_NONE:
+         text = " No Highlighting";
+         break;
+
+      default:
+         text = " Full Highlighting";
+         break;
+   }
+
+   if (m_textEdit->get_SyntaxMode() != SYNTAX_AUTO) {
+      // set by the user for this tab
+      text += " *";
+   }
+
+   m_statusSyntax->setText(text + "  ");
+}
+
 void MainWindow::setStatus_FName(QString fullName)
 {
    m_statusName->setText(" " + fullName + "  ");
@@ -562,11 +1382,14 @@ void MainWindow::dropEvent(QDropEvent *event)
          return;
       }
 
-      QString fileName = urls.first().toLocalFile();
-      if (! fileName.isEmpty()) {
-         loadFile(fileName, true, false);
+      QStringList fileList;
+
+      for (const QUrl &url : urls) {
+         fileList.append(url.toLocalFile());
       }
 
+      loadFiles(fileList, false);
+
    } else if (mimeData->hasText()) {
       QTextCursor cursor(m_textEdit->textCursor());
 
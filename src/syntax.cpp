@@ -16,182 +16,378 @@
 #include "syntax.h"
 #include "util.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include <QDataStream>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QSaveFile>
 #include <QString>
 #include <QTextBoundaryFinder>
+#include <QVarLengthArray>
 
 static const QRegularExpression DEFAULT_COMMENT = QRegularExpression("(?!E)E");
 
-Syntax::Syntax(QTextDocument *document, QString synFName, const struct Settings &settings, SpellCheck *spell)
-   : QSyntaxHighlighter(document)
+// documents larger than this (in characters) are highlighted in the background
+static const int SCHEDULE_MIN_SIZE = 256 * 1024;
+
+static const int ALL_BLOCKS = std::numeric_limits<int>::max();
+
+// background requests waiting on the worker, the time sliced pass stops submitting above this
+static const int MAX_PENDING = 512;
+
+// a block whose end state changed also requests this many of the following blocks
+static const int CHAIN_SIZE = 64;
+
+// blocks handed to a thread of the parallel pass at a time
+static const int INITIAL_CHUNK = 2000;
+
+// every thread of the parallel pass loads its own copy of the dictionary
+static const int MAX_INITIAL_WORKERS = 8;
+
+// bump the version when the layout of SyntaxDefinition or the rule merging changes
+static const quint32 CACHE_MAGIC   = 0x44534e43;
+static const quint32 CACHE_VERSION = 4;
+
+QHash<QString, std::shared_ptr<const SyntaxDefinition>> SyntaxDefinition::m_registry;
+std::atomic<bool> SyntaxDefinition::m_profiling(false);
+
+QString SyntaxDefinition::m_cacheFile;
+QHash<QString, QByteArray> SyntaxDefinition::m_cacheList;
+bool SyntaxDefinition::m_cacheLoaded = false;
+
+static void writePattern(QDataStream &stream, const QRegularExpression &pattern)
 {
-   m_syntaxFile   = synFName;
-   m_settings     = settings;
-   m_spellCheck   = spell;
+   bool ignoreCase = (pattern.patternOptions() & QPatternOption::CaseInsensitiveOption);
+   stream << pattern.pattern() << ignoreCase;
+}
 
-   m_isSpellCheck = settings.isSpellCheck;
+static QRegularExpression readPattern(QDataStream &stream)
+{
+   QString pattern;
+   bool ignoreCase;
+
+   stream >> pattern >> ignoreCase;
+
+   QRegularExpression retval(pattern);
+
+   if (ignoreCase) {
+      retval.setPatternOptions(QPatternOption::CaseInsensitiveOption);
+   }
+
+   return retval;
 }
 
-Syntax::~Syntax()
+SyntaxDefinition::SyntaxDefinition()
 {
+   m_fileSize   = 0;
+   m_ignoreCase = false;
+   m_isNative   = true;
+   m_lexer      = LEXER_NONE;
+
+   m_spellScope   = SPELL_ALL;
+   m_isSpellSplit = true;
 }
 
-bool Syntax::processSyntax(const struct Settings &settings)
+std::shared_ptr<const SyntaxDefinition> SyntaxDefinition::get(const QString &fileName, SyntaxTypes type)
 {
-   // only called from Dialog_Colors
-   m_settings = settings;
+   // every tab using the same syntax file shares one compiled definition
+   QFileInfo info(fileName);
 
-   return processSyntax();
+   QString key = fileName + "#" + QString::number(type);
+
+   auto iter = m_registry.find(key);
+
+   if (iter != m_registry.end()) {
+      const SyntaxDefinition &item = *iter.value();
+
+      if (info.exists() && info.size() == item.m_fileSize && info.lastModified() == item.m_lastModified) {
+         return iter.value();
+      }
+
+      // file was edited, tabs holding the old definition keep it until they reload
+      m_registry.erase(iter);
+   }
+
+   std::shared_ptr<SyntaxDefinition> definition(new SyntaxDefinition);
+
+   definition->m_syntaxFile   = fileName;
+   definition->m_fileSize     = info.size();
+   definition->m_lastModified = info.lastModified();
+
+   if (! info.exists() || ! definition->cacheRead()) {
+      QByteArray data = json_ReadFile(fileName);
+
+      if (data.isEmpty()) {
+         return std::shared_ptr<const SyntaxDefinition>();
+      }
+
+      if (! definition->processSyntax(data)) {
+         return std::shared_ptr<const SyntaxDefinition>();
+      }
+
+      definition->cacheWrite();
+   }
+
+   if (definition->m_isNative) {
+      definition->m_lexer = SyntaxLexer::lexerType(type);
+   }
+
+   if (definition->m_spellScopeName == "all") {
+      definition->m_spellScope = SPELL_ALL;
+
+   } else if (definition->m_spellScopeName == "comments") {
+      definition->m_spellScope = SPELL_COMMENTS;
+
+   } else if (type == SYN_TEXT || type == SYN_NONE || type == SYN_HTML) {
+      definition->m_spellScope = SPELL_ALL;
+
+   } else {
+      // source code, keywords and identifiers are not prose
+      definition->m_spellScope = SPELL_COMMENTS;
+
+   }
+
+   definition->checkRules();
+   definition->buildFilters();
+
+   m_registry.insert(key, definition);
+
+   return definition;
 }
 
-bool Syntax::processSyntax()
+void SyntaxDefinition::setCacheFile(const QString &fileName)
 {
-   // get existing json data
-   QByteArray data = json_ReadFile(m_syntaxFile);
+   m_cacheFile   = fileName;
+   m_cacheLoaded = false;
 
-   if (data.isEmpty()) {
-      return false;
+   m_cacheList.clear();
+}
+
+void SyntaxDefinition::cacheLoad()
+{
+   if (m_cacheLoaded) {
+      return;
    }
 
-   QJsonDocument doc = QJsonDocument::fromJson(data);
+   m_cacheLoaded = true;
 
-   QJsonObject object = doc.object();
-   QJsonArray list;
-   int cnt;
+   if (m_cacheFile.isEmpty()) {
+      return;
+   }
 
-   //
-   bool ignoreCase = object.value("ignore-case").toBool();
+   QFile file(m_cacheFile);
+
+   if (! file.open(QFile::ReadOnly)) {
+      // no cache yet
+      return;
+   }
 
-   // * key
-   QStringList key_Patterns;
+   QDataStream stream(&file);
 
-   list = object.value("keywords").toArray();
-   cnt  = list.count();
+   quint32 magic;
+   quint32 version;
 
-   for (int k = 0; k < cnt; k++)  {
-      key_Patterns.append(list.at(k).toString());
+   stream >> magic >> version;
+
+   if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+      return;
    }
 
-   // class
-   QStringList class_Patterns;
+   stream >> m_cacheList;
 
-   list = object.value("classes").toArray();
-   cnt  = list.count();
+   if (stream.status() != QDataStream::Ok) {
+      // damaged file, rebuilt as syntax files are loaded
+      m_cacheList.clear();
+   }
+}
 
-   for (int k = 0; k < cnt; k++)  {
-      class_Patterns.append(list.at(k).toString());
+void SyntaxDefinition::cacheSave()
+{
+   if (m_cacheFile.isEmpty()) {
+      return;
    }
 
-   // functions
-   QStringList func_Patterns;
+   // replaced in one step, a crash or a second instance never leaves a truncated cache
+   QSaveFile file(m_cacheFile);
+
+   if (! file.open(QFile::WriteOnly)) {
+      // cache is optional, the syntax files are still read directly
+      return;
+   }
 
-   list = object.value("functions").toArray();
-   cnt  = list.count();
+   QDataStream stream(&file);
+   stream << CACHE_MAGIC << CACHE_VERSION << m_cacheList;
 
-   for (int k = 0; k < cnt; k++)  {
-      func_Patterns.append(list.at(k).toString());
+   if (stream.status() != QDataStream::Ok) {
+      file.cancelWriting();
    }
 
-   // types
-   QStringList type_Patterns;
+   file.commit();
+}
+
+bool SyntaxDefinition::cacheRead()
+{
+   cacheLoad();
 
-   list = object.value("types").toArray();
-   cnt  = list.count();
+   auto iter = m_cacheList.constFind(m_syntaxFile);
 
-   for (int k = 0; k < cnt; k++)  {
-      type_Patterns.append(list.at(k).toString());
+   if (iter == m_cacheList.constEnd()) {
+      return false;
    }
 
-   //
-   HighlightingRule rule;
+   QDataStream stream(iter.value());
 
-   for (const QString &pattern : key_Patterns) {
-      if (pattern.trimmed().isEmpty()) {
-         continue;
-      }
+   qint64 fileSize;
+   qint64 lastModified;
 
-      // key
-      rule.format.setFontWeight(m_settings.syn_KeyWeight);
-      rule.format.setFontItalic(m_settings.syn_KeyItalic);
-      rule.format.setForeground(m_settings.syn_KeyText);
-      rule.pattern = QRegularExpression(pattern);
+   stream >> fileSize >> lastModified;
 
-      if (ignoreCase) {
-         rule.pattern.setPatternOptions(QPatternOption::CaseInsensitiveOption);
-      }
-      highlightingRules.append(rule);
+   if (fileSize != m_fileSize || lastModified != m_lastModified.toMSecsSinceEpoch()) {
+      return false;
    }
 
-   for (const QString &pattern : class_Patterns) {
-      if (pattern.trimmed().isEmpty()) {
-         continue;
-      }
+   qint32 ruleCnt;
+   qint32 passCnt;
 
-      // class
-      rule.format.setFontWeight(m_settings.syn_ClassWeight);
-      rule.format.setFontItalic(m_settings.syn_ClassItalic);
-      rule.format.setForeground(m_settings.syn_ClassText);
-      rule.pattern = QRegularExpression(pattern);
+   stream >> m_ignoreCase >> m_isNative >> m_spellScopeName >> m_isSpellSplit;
 
-      if (ignoreCase) {
-         rule.pattern.setPatternOptions(QPatternOption::CaseInsensitiveOption);
+   m_commentStartExpression = readPattern(stream);
+   m_commentEndExpression   = readPattern(stream);
+
+   stream >> ruleCnt;
+
+   for (int k = 0; k < ruleCnt && stream.status() == QDataStream::Ok; ++k) {
+      HighlightingRule rule;
+      qint32 token;
+
+      rule.pattern = readPattern(stream);
+      stream >> token;
+
+      if (token < 0 || token >= TOKEN_COUNT) {
+         stream.setStatus(QDataStream::ReadCorruptData);
+         break;
       }
 
+      rule.token = static_cast<SyntaxToken>(token);
       highlightingRules.append(rule);
    }
 
-   for (const QString &pattern : func_Patterns) {
-      if (pattern.trimmed().isEmpty()) {
-         continue;
+   stream >> passCnt;
+
+   for (int k = 0; k < passCnt && stream.status() == QDataStream::Ok; ++k) {
+      HighlightingPass pass;
+
+      pass.pattern = readPattern(stream);
+      stream >> pass.ruleList >> pass.keywords;
+
+      for (int rule : pass.ruleList) {
+         if (rule < 0 || rule >= highlightingRules.size()) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+         }
       }
 
-      // func
-      rule.format.setFontWeight(m_settings.syn_FuncWeight);
-      rule.format.setFontItalic(m_settings.syn_FuncItalic);
-      rule.format.setForeground(m_settings.syn_FuncText);
-      rule.pattern = QRegularExpression(pattern);
+      for (int rule : pass.keywords) {
+         if (rule < 0 || rule >= highlightingRules.size()) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+         }
+      }
 
-      if (ignoreCase) {
-         rule.pattern.setPatternOptions(QPatternOption::CaseInsensitiveOption);
+      if (stream.status() == QDataStream::Ok && ! isPassValid(pass)) {
+         // written by a version which merged other rules, compiled again from the syntax file
+         stream.setStatus(QDataStream::ReadCorruptData);
       }
 
-      highlightingRules.append(rule);
+      highlightingPasses.append(pass);
    }
 
-   for (const QString &pattern : type_Patterns) {
-      if (pattern.trimmed().isEmpty()) {
-         continue;
-      }
+   if (stream.status() != QDataStream::Ok) {
+      highlightingRules.clear();
+      highlightingPasses.clear();
 
-      // types
-      rule.format.setFontWeight(m_settings.syn_TypeWeight);
-      rule.format.setFontItalic(m_settings.syn_TypeItalic);
-      rule.format.setForeground(m_settings.syn_TypeText);
-      rule.pattern = QRegularExpression(pattern);
+      return false;
+   }
 
-      if (ignoreCase) {
-         rule.pattern.setPatternOptions(QPatternOption::CaseInsensitiveOption);
-      }
-      highlightingRules.append(rule);
+   return true;
+}
+
+void SyntaxDefinition::cacheWrite() const
+{
+   if (m_cacheFile.isEmpty()) {
+      return;
+   }
+
+   QByteArray data;
+   QDataStream stream(&data, QIODevice::WriteOnly);
+
+   stream << qint64(m_fileSize) << qint64(m_lastModified.toMSecsSinceEpoch());
+   stream << m_ignoreCase << m_isNative << m_spellScopeName << m_isSpellSplit;
+
+   writePattern(stream, m_commentStartExpression);
+   writePattern(stream, m_commentEndExpression);
+
+   stream << qint32(highlightingRules.size());
+
+   for (const auto &rule : highlightingRules) {
+      writePattern(stream, rule.pattern);
+      stream << qint32(rule.token);
+   }
+
+   stream << qint32(highlightingPasses.size());
+
+   for (const auto &pass : highlightingPasses) {
+      writePattern(stream, pass.pattern);
+      stream << pass.ruleList << pass.keywords;
    }
 
+   cacheLoad();
+   m_cacheList.insert(m_syntaxFile, data);
+
+   cacheSave();
+}
+
+bool SyntaxDefinition::processSyntax(const QByteArray &data)
+{
+   QJsonDocument doc = QJsonDocument::fromJson(data);
+
+   QJsonObject object = doc.object();
+
+   //
+   bool ignoreCase = object.value("ignore-case").toBool();
+   m_isNative      = object.value("native-lexer").toBool(true);
+
+   m_spellScopeName = object.value("spell-scope").toString();
+   m_isSpellSplit   = object.value("spell-split").toBool(true);
+
+   addRules(object.value("keywords").toArray(),  TOKEN_KEY,   ignoreCase);
+   addRules(object.value("classes").toArray(),   TOKEN_CLASS, ignoreCase);
+   addRules(object.value("functions").toArray(), TOKEN_FUNC,  ignoreCase);
+   addRules(object.value("types").toArray(),     TOKEN_TYPE,  ignoreCase);
+
+   HighlightingRule rule;
+
    // quoted text - everyone
-   rule.format.setFontWeight(m_settings.syn_QuoteWeight);
-   rule.format.setFontItalic(m_settings.syn_QuoteItalic);
-   rule.format.setForeground(m_settings.syn_QuoteText);
+   rule.token   = TOKEN_QUOTE;
    rule.pattern = QRegularExpression("\".*?\"");
    highlightingRules.append(rule);
 
    // single line comment
    QString commentSingle = object.value("comment-single").toString();
 
-   rule.format.setFontWeight(m_settings.syn_CommentWeight);
-   rule.format.setFontItalic(m_settings.syn_CommentItalic);
-   rule.format.setForeground(m_settings.syn_CommentText);
+   rule.token   = TOKEN_COMMENT;
    rule.pattern = QRegularExpression(commentSingle);
    highlightingRules.append(rule);
 
@@ -199,36 +395,58 @@ bool Syntax::processSyntax()
    QString commentStart = object.value("comment-multi-start").toString();
    QString commentEnd   = object.value("comment-multi-end").toString();
 
-   m_multiLineCommentFormat.setFontWeight(m_settings.syn_MLineWeight);
-   m_multiLineCommentFormat.setFontItalic(m_settings.syn_MLineItalic);
-   m_multiLineCommentFormat.setForeground(m_settings.syn_MLineText);
    m_commentStartExpression = QRegularExpression(commentStart);
    m_commentEndExpression   = QRegularExpression(commentEnd);
 
-   // spell check
-   m_spellCheckFormat.setUnderlineColor(QColor(Qt::red));
+   if (m_commentStartExpression.pattern().isEmpty()) {
+      m_commentStartExpression = DEFAULT_COMMENT;
+   }
 
-   // pending CS 1.6.1
-   // m_spellCheckFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
-   m_spellCheckFormat.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+   if (m_commentEndExpression.pattern().isEmpty()) {
+      m_commentEndExpression = DEFAULT_COMMENT;
+   }
 
-   // redo the current document
-   rehighlight();
+   // runs of literal word rules share one keyword table, every other rule is a pass of its own
+   buildPasses(ignoreCase);
 
    return true;
 }
 
-QByteArray Syntax::json_ReadFile(QString fileName)
+void SyntaxDefinition::addRules(const QJsonArray &list, SyntaxToken token, bool ignoreCase)
+{
+   HighlightingRule rule;
+   rule.token = token;
+
+   int cnt = list.count();
+
+   for (int k = 0; k < cnt; k++)  {
+      QString pattern = list.at(k).toString();
+
+      if (pattern.trimmed().isEmpty()) {
+         continue;
+      }
+
+      rule.pattern = QRegularExpression(pattern);
+
+      if (ignoreCase) {
+         rule.pattern.setPatternOptions(QPatternOption::CaseInsensitiveOption);
+      }
+
+      highlightingRules.append(rule);
+   }
+}
+
+QByteArray SyntaxDefinition::json_ReadFile(QString fileName)
 {
    QByteArray data;
 
    if (fileName.isEmpty()) {
-      csError(tr("Read Json Syntax"), tr("Syntax file name was not supplied."));
+      csError(QObject::tr("Read Json Syntax"), QObject::tr("Syntax file name was not supplied."));
       return data;
    }
 
    if (! QFile::exists(fileName) ) {
-      csError(tr("Read Json Syntax"), tr("Syntax file was not found: ") + fileName + "\n\n"
+      csError(QObject::tr("Read Json Syntax"), QObject::tr("Syntax file was not found: ") + fileName + "\n\n"
               "To specify the location of the syntax files select 'Settings' from the main Menu. "
               "Then select 'General Options' and click on the Options tab.\n");
 
@@ -237,8 +455,8 @@ QByteArray Syntax::json_ReadFile(QString fileName)
 
    QFile file(fileName);
    if (! file.open(QFile::ReadOnly | QFile::Text)) {
-      const QString msg = tr("Unable to open Json Syntax file: ") +  fileName + " : " + file.errorString();
-      csError(tr("Read Json Syntax"), msg);
+      const QString msg = QObject::tr("Unable to open Json Syntax file: ") +  fileName + " : " + file.errorString();
+      csError(QObject::tr("Read Json Syntax"), msg);
       return data;
    }
 
@@ -249,79 +467,1904 @@ QByteArray Syntax::json_ReadFile(QString fileName)
    return data;
 }
 
-void Syntax::set_Spell(bool value)
+QString SyntaxDefinition::literalWord(const QString &pattern)
 {
-   m_isSpellCheck = value;
+   // only rules for one literal word share a pass, two different words never overlap and the hash
+   // lookup finds every occurrence, a regex alternation returns one branch per position and would lose
+   // shorter or overlapping matches like \btable-row\b inside table-row-group
+   static const QRegularExpression literal("^\\\\b([A-Za-z0-9_]+)\\\\b$");
+
+   return literal.match(pattern).captured(1);
 }
 
-void Syntax::highlightBlock(const QString &text)
+void SyntaxDefinition::buildPasses(bool ignoreCase)
 {
-   QRegularExpressionMatch match;
+   // a pass is a single rule or a run of literal word rules, rule order is the color precedence (last rule wins)
+   m_ignoreCase = ignoreCase;
 
-   for (auto &rule : highlightingRules) {
-      match = rule.pattern.match(text);
+   HighlightingPass wordPass;
 
-      while (match.hasMatch()) {
-         int index  = match.capturedStart(0) - text.begin();
-         int length = match.capturedLength();
+   int cnt = highlightingRules.size();
 
-         setFormat(index, length, rule.format);
+   for (int k = 0; k < cnt; ++k) {
+      const QRegularExpression &pattern = highlightingRules[k].pattern;
 
-         // get new match
-         match = rule.pattern.match(text, match.capturedEnd(0));
+      if (! pattern.isValid() || pattern.pattern().isEmpty()) {
+         // an invalid or empty rule never matches
+         continue;
       }
-   }
 
-   // multi line comments
-   setCurrentBlockState(0);
+      QString word = literalWord(pattern.pattern());
 
-   int startIndex = 0;
+      if (! word.isEmpty()) {
 
-   if (m_commentStartExpression.pattern().isEmpty()) {
-      m_commentStartExpression = DEFAULT_COMMENT;
+         if (ignoreCase) {
+            word = word.toLower();
+         }
+
+         // a later rule for the same word has the higher precedence
+         wordPass.keywords.insert(word, k);
+         continue;
+      }
+
+      if (! wordPass.keywords.isEmpty()) {
+         highlightingPasses.append(wordPass);
+         wordPass = HighlightingPass();
+      }
+
+      HighlightingPass pass;
+
+      pass.pattern = pattern;
+      pass.ruleList.append(k);
+
+      highlightingPasses.append(pass);
    }
 
-   if (m_commentEndExpression.pattern().isEmpty()) {
-      m_commentEndExpression = DEFAULT_COMMENT;
+   if (! wordPass.keywords.isEmpty()) {
+      highlightingPasses.append(wordPass);
    }
+}
 
-   if (previousBlockState() != 1) {
-      startIndex = text.indexOf(m_commentStartExpression);
+bool SyntaxDefinition::isPassValid(const HighlightingPass &pass) const
+{
+   // regression check for the merging, a pass is one rule of any kind or only literal words
+   if (pass.keywords.isEmpty()) {
+      return pass.ruleList.size() == 1;
    }
 
-   while (startIndex >= 0) {
-      int commentLength;
-      match = m_commentEndExpression.match(text, text.begin() + startIndex);
+   if (! pass.ruleList.isEmpty()) {
+      return false;
+   }
 
-      if (match.hasMatch()) {
-         int endIndex  = match.capturedStart(0) - text.begin();
-         commentLength = endIndex - startIndex + match.capturedLength();
+   for (auto iter = pass.keywords.constBegin(); iter != pass.keywords.constEnd(); ++iter) {
+      QString word = literalWord(highlightingRules[iter.value()].pattern.pattern());
 
-      } else {
-         setCurrentBlockState(1);
-         commentLength = text.length() - startIndex;
+      if (m_ignoreCase) {
+         word = word.toLower();
+      }
 
+      if (word != iter.key()) {
+         return false;
       }
+   }
 
-      setFormat(startIndex, commentLength, m_multiLineCommentFormat);
-      startIndex = text.indexOf(m_commentStartExpression, startIndex + commentLength);
+   return true;
+}
+
+void SyntaxDefinition::buildFilters()
+{
+   m_filterList.clear();
+
+   for (const auto &pass : highlightingPasses) {
+      QVector<QRegularExpression> patternList;
+
+      for (int rule : pass.ruleList) {
+         patternList.append(highlightingRules[rule].pattern);
+      }
+
+      m_filterList.append(makeFilter(patternList));
    }
 
-   // spell check
+   m_commentFilter = makeFilter( {m_commentStartExpression} );
+}
+
+SyntaxDefinition::PassFilter SyntaxDefinition::makeFilter(const QVector<QRegularExpression> &patternList) const
+{
+   PassFilter filter;
 
-   if (m_spellCheck && m_isSpellCheck)  {
-      QTextBoundaryFinder wordFinder(QTextBoundaryFinder::Word, text);
+   filter.isActive   = ! patternList.isEmpty();
+   filter.ignoreCase = false;
 
-      while (wordFinder.position() < text.length()) {
-         int wordStart  = wordFinder.position();
-         int wordLength = wordFinder.toNextBoundary() - wordStart;
+   for (const auto &pattern : patternList) {
+      if (pattern.patternOptions() & QPatternOption::CaseInsensitiveOption) {
+         filter.ignoreCase = true;
+      }
+   }
+
+   for (const auto &pattern : patternList) {
+      QByteArray literal = requiredLiteral(pattern.pattern());
+
+      if (literal.isEmpty()) {
+         // one rule without a literal can match anywhere
+         filter.isActive = false;
+         break;
+      }
+
+      if (filter.ignoreCase) {
+         literal = literal.toLower();
 
-         QStringView word = text.midView(wordStart, wordLength).trimmed();
+         char upper = std::toupper(static_cast<unsigned char>(literal[0]));
 
-         if ( ! m_spellCheck->spell(word) )   {
-            setFormat(wordStart, wordLength, m_spellCheckFormat);
+         if (! filter.firstList.contains(upper)) {
+            filter.firstList.append(upper);
          }
       }
+
+      if (! filter.firstList.contains(literal[0])) {
+         filter.firstList.append(literal[0]);
+      }
+
+      filter.literalList.append(literal);
    }
+
+   return filter;
 }
 
+QByteArray SyntaxDefinition::requiredLiteral(const QString &pattern)
+{
+   // ascii text every match has to start with, empty when the pattern does not require one
+   QByteArray data = pattern.toUtf8();
+   QByteArray retval;
+
+   int size = data.size();
+
+   // an alternation at the top level means no single prefix is required
+   int depth    = 0;
+   bool isClass = false;
+
+   for (int k = 0; k < size; ++k) {
+      char c = data[k];
+
+      if (c == '\\') {
+         ++k;
+
+      } else if (isClass) {
+         isClass = (c != ']');
+
+      } else if (c == '[') {
+         isClass = true;
+
+      } else if (c == '(') {
+         ++depth;
+
+      } else if (c == ')') {
+         --depth;
+
+      } else if (c == '|' && depth == 0) {
+         return retval;
+
+      }
+   }
+
+   int k = 0;
+
+   if (data.startsWith("\\b")) {
+      k = 2;
+
+   } else if (data.startsWith("^")) {
+      k = 1;
+
+   }
+
+   while (k < size) {
+      unsigned char c = data[k];
+      int next = k + 1;
+
+      if (c == '\\') {
+         // escaped punctuation is literal, an escaped letter is a class or an anchor
+         c = next < size ? data[next] : 0;
+
+         if (c == 0 || c >= 0x80 || std::isalnum(c)) {
+            break;
+         }
+
+         next = k + 2;
+
+      } else if (c >= 0x80 || std::strchr(".[](){}*+?|^$", c) != nullptr) {
+         break;
+
+      }
+
+      // a quantifier makes the character optional, + still requires one
+      char quantifier = next < size ? data[next] : 0;
+
+      if (quantifier == '?' || quantifier == '*' || quantifier == '{') {
+         break;
+      }
+
+      retval.append(c);
+
+      if (quantifier == '+') {
+         break;
+      }
+
+      k = next;
+   }
+
+   return retval;
+}
+
+static bool isLiteralAt(const QVector<QByteArray> &literalList, bool ignoreCase, const unsigned char *pos, qint64 size)
+{
+   for (const auto &literal : literalList) {
+      int len = literal.size();
+
+      if (size < len) {
+         continue;
+      }
+
+      int j = 0;
+
+      while (j < len) {
+         unsigned char c = pos[j];
+
+         if (ignoreCase) {
+            c = std::tolower(c);
+         }
+
+         if (c != static_cast<unsigned char>(literal[j])) {
+            break;
+         }
+
+         ++j;
+      }
+
+      if (j == len) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+bool SyntaxDefinition::isPossible(const PassFilter &filter, const unsigned char *data, int size)
+{
+   if (! filter.isActive) {
+      return true;
+   }
+
+   // one memchr per distinct first byte, memchr is vectorized by the C library, the earliest hit is
+   // compared with the literals and only that byte is searched again
+   const unsigned char *end = data + size;
+
+   int cnt = filter.firstList.size();
+   QVarLengthArray<const unsigned char *, 16> nextList(cnt);
+
+   for (int k = 0; k < cnt; ++k) {
+      nextList[k] = static_cast<const unsigned char *>(std::memchr(data, filter.firstList[k], size));
+   }
+
+   while (true) {
+      int best = -1;
+
+      for (int k = 0; k < cnt; ++k) {
+         if (nextList[k] != nullptr && (best < 0 || nextList[k] < nextList[best])) {
+            best = k;
+         }
+      }
+
+      if (best < 0) {
+         return false;
+      }
+
+      const unsigned char *pos = nextList[best];
+
+      if (isLiteralAt(filter.literalList, filter.ignoreCase, pos, end - pos)) {
+         return true;
+      }
+
+      ++pos;
+      nextList[best] = static_cast<const unsigned char *>(std::memchr(pos, filter.firstList[best], end - pos));
+   }
+}
+
+bool SyntaxDefinition::isLexical(const HighlightingPass &pass) const
+{
+   // the quote and single line comment rules, replaced by the native lexer
+   if (pass.ruleList.size() != 1 || ! pass.keywords.isEmpty()) {
+      return false;
+   }
+
+   SyntaxToken token = highlightingRules[pass.ruleList.first()].token;
+
+   return token == TOKEN_QUOTE || token == TOKEN_COMMENT;
+}
+
+void SyntaxDefinition::findWords(const QString &text, QVector<HighlightWord> &wordList) const
+{
+   // split the block into identifiers once, each keyword table is then a hash lookup per word
+   HighlightWord word;
+   word.start  = -1;
+   word.length = 0;
+
+   int index = 0;
+
+   for (QChar c : text) {
+
+      if (c.isLetterOrNumber() || c == QChar('_')) {
+
+         if (word.start < 0) {
+            word.start = index;
+         }
+
+         word.text.append(c);
+         ++word.length;
+
+      } else if (word.start >= 0) {
+
+         if (m_ignoreCase) {
+            word.text = word.text.toLower();
+         }
+
+         wordList.append(word);
+
+         word.start  = -1;
+         word.length = 0;
+         word.text.clear();
+      }
+
+      ++index;
+   }
+
+   if (word.start >= 0) {
+
+      if (m_ignoreCase) {
+         word.text = word.text.toLower();
+      }
+
+      wordList.append(word);
+   }
+}
+
+int SyntaxDefinition::tokenize(const QString &text, int prevState, QVector<SyntaxRun> &runList, SyntaxMode mode) const
+{
+   QRegularExpressionMatch match;
+
+   QVector<HighlightWord> wordList;
+   bool wordsFound = false;
+
+   QVector<HighlightMatch> matchList;
+
+   bool isFull   = (mode == SYNTAX_FULL);
+   bool isNative = (m_lexer != LEXER_NONE);
+
+   // most blocks have no quotes or comments, passes whose literal is missing skip the regex engine
+   const unsigned char *bytes = reinterpret_cast<const unsigned char *>(text.constData());
+   int byteCount = text.size_storage();
+
+   // instrumentation
+   using Clock = std::chrono::steady_clock;
+
+   bool isProfile = m_profiling;
+   int passIndex  = 0;
+
+   QVector<PassProfile> passProfile;
+   QVector<qint64> ruleHits;
+   Clock::time_point passStart;
+
+   if (isProfile) {
+      passProfile.fill( {0, 0, 0}, highlightingPasses.size() + 1);
+      ruleHits.fill(0, highlightingRules.size());
+   }
+
+   for (const auto &pass : highlightingPasses) {
+      matchList.clear();
+
+      if (isProfile) {
+         passStart = Clock::now();
+      }
+
+      bool isRegex = isFull && ! pass.ruleList.isEmpty() && ! (isNative && isLexical(pass));
+
+      if (isRegex && passIndex < m_filterList.size()) {
+         isRegex = isPossible(m_filterList[passIndex], bytes, byteCount);
+      }
+
+      if (isRegex) {
+         match = pass.pattern.match(text);
+
+         if (isProfile) {
+            ++passProfile[passIndex].calls;
+         }
+
+         while (match.hasMatch()) {
+            int index  = match.capturedStart(0) - text.begin();
+            int length = match.capturedLength();
+
+            matchList.append( {index, length, pass.ruleList.first()} );
+
+            // get new match
+            match = pass.pattern.match(text, match.capturedEnd(0));
+
+            if (isProfile) {
+               ++passProfile[passIndex].calls;
+            }
+         }
+      }
+
+      if (! pass.keywords.isEmpty()) {
+
+         if (! wordsFound) {
+            findWords(text, wordList);
+            wordsFound = true;
+         }
+
+         if (isProfile) {
+            passProfile[passIndex].calls += wordList.size();
+         }
+
+         // words do not overlap, the order the runs are applied in does not matter
+         for (const auto &word : wordList) {
+            auto iter = pass.keywords.constFind(word.text);
+
+            if (iter != pass.keywords.constEnd()) {
+               matchList.append( {word.start, word.length, iter.value()} );
+            }
+         }
+      }
+
+      for (const auto &item : matchList) {
+         runList.append( {item.start, item.length, highlightingRules[item.rule].token} );
+      }
+
+      if (isProfile) {
+         qint64 elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - passStart).count();
+
+         passProfile[passIndex].totalTime = elapsed;
+         passProfile[passIndex].worstTime = elapsed;
+
+         for (const auto &item : matchList) {
+            ++ruleHits[item.rule];
+         }
+      }
+
+      ++passIndex;
+   }
+
+   if (! isFull) {
+      if (isProfile) {
+         recordProfile(passProfile, ruleHits);
+      }
+
+      return 0;
+   }
+
+   if (isProfile) {
+      passStart = Clock::now();
+   }
+
+   // multi line comments
+   int state      = 0;
+   int startIndex = -1;
+
+   if (isNative) {
+      // quotes and comments, applied last so they win over keywords
+      state = SyntaxLexer::tokenize(m_lexer, text, prevState, runList);
+
+   } else if (prevState != 1) {
+
+      if (isPossible(m_commentFilter, bytes, byteCount)) {
+         startIndex = text.indexOf(m_commentStartExpression);
+      }
+
+   } else {
+      startIndex = 0;
+
+   }
+
+   while (startIndex >= 0) {
+      int commentLength;
+      match = m_commentEndExpression.match(text, text.begin() + startIndex);
+
+      if (match.hasMatch()) {
+         int endIndex  = match.capturedStart(0) - text.begin();
+         commentLength = endIndex - startIndex + match.capturedLength();
+
+      } else {
+         state = 1;
+         commentLength = text.length() - startIndex;
+
+      }
+
+      runList.append( {startIndex, commentLength, TOKEN_MLINE} );
+      startIndex = text.indexOf(m_commentStartExpression, startIndex + commentLength);
+   }
+
+   if (isProfile) {
+      qint64 elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - passStart).count();
+
+      passProfile[passIndex].calls     = 1;
+      passProfile[passIndex].totalTime = elapsed;
+      passProfile[passIndex].worstTime = elapsed;
+
+      recordProfile(passProfile, ruleHits);
+   }
+
+   return state;
+}
+
+void SyntaxDefinition::recordProfile(const QVector<PassProfile> &passProfile, const QVector<qint64> &ruleHits) const
+{
+   std::lock_guard<std::mutex> lock(m_profileMutex);
+
+   if (m_passProfile.size() != passProfile.size()) {
+      m_passProfile.fill( {0, 0, 0}, passProfile.size());
+      m_ruleHits.fill(0, ruleHits.size());
+   }
+
+   for (int k = 0; k < passProfile.size(); ++k) {
+      PassProfile &item = m_passProfile[k];
+
+      item.calls     += passProfile[k].calls;
+      item.totalTime += passProfile[k].totalTime;
+      item.worstTime  = std::max(item.worstTime, passProfile[k].worstTime);
+   }
+
+   for (int k = 0; k < ruleHits.size(); ++k) {
+      m_ruleHits[k] += ruleHits[k];
+   }
+}
+
+SpellScope SyntaxDefinition::spellScope() const
+{
+   return m_spellScope;
+}
+
+bool SyntaxDefinition::isSpellSplit() const
+{
+   return m_isSpellSplit;
+}
+
+void SyntaxDefinition::setProfiling(bool enable)
+{
+   m_profiling = enable;
+}
+
+bool SyntaxDefinition::isProfiling()
+{
+   return m_profiling;
+}
+
+void SyntaxDefinition::resetProfile()
+{
+   for (const auto &item : m_registry) {
+      std::lock_guard<std::mutex> lock(item->m_profileMutex);
+
+      item->m_passProfile.clear();
+      item->m_ruleHits.clear();
+   }
+}
+
+QJsonArray SyntaxDefinition::profileReport()
+{
+   // one entry per pass of every loaded definition, merged rules share the time of their pass
+   QJsonArray retval;
+
+   static const QStringList tokenNames = { "keyword", "class", "function", "type", "quote",
+         "comment", "comment-multi", "spell" };
+
+   for (const auto &item : m_registry) {
+      const SyntaxDefinition &definition = *item;
+
+      std::lock_guard<std::mutex> lock(definition.m_profileMutex);
+
+      int passCnt = definition.highlightingPasses.size();
+
+      for (int k = 0; k <= passCnt; ++k) {
+         QJsonObject object;
+         QJsonArray ruleList;
+
+         qint64 hits = 0;
+
+         if (k < passCnt) {
+            const HighlightingPass &pass = definition.highlightingPasses[k];
+
+            QVector<int> indexList = pass.ruleList;
+
+            for (int rule : pass.keywords) {
+               if (! indexList.contains(rule)) {
+                  indexList.append(rule);
+               }
+            }
+
+            std::sort(indexList.begin(), indexList.end());
+
+            for (int rule : indexList) {
+               QJsonObject ruleObject;
+               qint64 ruleHits = rule < definition.m_ruleHits.size() ? definition.m_ruleHits[rule] : 0;
+
+               ruleObject.insert("pattern", definition.highlightingRules[rule].pattern.pattern());
+               ruleObject.insert("token",   tokenNames[definition.highlightingRules[rule].token]);
+               ruleObject.insert("hits",    ruleHits);
+
+               if (! definition.m_warningList.value(rule).isEmpty()) {
+                  ruleObject.insert("warning", definition.m_warningList[rule]);
+               }
+
+               ruleList.append(ruleObject);
+               hits += ruleHits;
+            }
+
+            object.insert("keywords", pass.keywords.size());
+
+         } else {
+            QJsonObject ruleObject;
+
+            if (definition.m_lexer != LEXER_NONE) {
+               ruleObject.insert("pattern", QString("native lexer"));
+               ruleObject.insert("token",   tokenNames[TOKEN_QUOTE] + ", " + tokenNames[TOKEN_COMMENT]);
+
+            } else {
+               ruleObject.insert("pattern", definition.m_commentStartExpression.pattern() + " ... " +
+                     definition.m_commentEndExpression.pattern());
+               ruleObject.insert("token",   tokenNames[TOKEN_MLINE]);
+            }
+
+            ruleList.append(ruleObject);
+         }
+
+         PassProfile profile = {0, 0, 0};
+
+         if (k < definition.m_passProfile.size()) {
+            profile = definition.m_passProfile[k];
+         }
+
+         object.insert("file",          QFileInfo(definition.m_syntaxFile).fileName());
+         object.insert("pass",          k);
+         object.insert("rules",         ruleList);
+         object.insert("calls",         profile.calls);
+         object.insert("hits",          hits);
+         object.insert("total-ms",      profile.totalTime / 1.0e6);
+         object.insert("worst-block-ms", profile.worstTime / 1.0e6);
+
+         retval.append(object);
+      }
+   }
+
+   return retval;
+}
+
+void SyntaxDefinition::checkRules()
+{
+   m_warningList.clear();
+
+   for (const auto &rule : highlightingRules) {
+      m_warningList.append(checkPattern(rule.pattern.pattern()));
+   }
+}
+
+QString SyntaxDefinition::checkPattern(const QString &pattern)
+{
+   // heuristics only, a flagged pattern is worth profiling on a long line
+
+   // quantified group which contains a quantifier, (a+)+ or (\w*\s?)* backtrack exponentially
+   static const QRegularExpression nestedQuantifier("\\((?:[^()\\\\]|\\\\.)*[*+](?:[^()\\\\]|\\\\.)*\\)[*+{]");
+
+   // unescaped . followed by * or +
+   static const QRegularExpression wildcard("(?<!\\\\)\\.[*+]\\??");
+
+   if (pattern.contains(nestedQuantifier)) {
+      return QObject::tr("Nested quantifier, exponential backtracking on a failed match");
+   }
+
+   int cnt = 0;
+   bool isTrailing = false;
+
+   QRegularExpressionMatch match = wildcard.match(pattern);
+
+   while (match.hasMatch()) {
+      ++cnt;
+
+      // more pattern after the wildcard, every shorter length is retried when it does not match
+      isTrailing = match.capturedEnd(0) != pattern.end();
+
+      match = wildcard.match(pattern, match.capturedEnd(0));
+   }
+
+   if (cnt > 1) {
+      return QObject::tr("Several wildcards, polynomial backtracking on long lines");
+   }
+
+   if (cnt == 1 && isTrailing) {
+      return QObject::tr("Wildcard followed by more pattern, quadratic on long lines without a match");
+   }
+
+   return QString();
+}
+
+SyntaxBlockData::SyntaxBlockData()
+{
+   textHash          = 0;
+   textLength        = -1;
+   prevState         = -1;
+   generation        = -1;
+   spellRevision     = -1;
+
+   endState          = -1;
+   isApplied         = false;
+
+   requestHash       = 0;
+   requestState      = -1;
+   requestGeneration = -1;
+   requestRevision   = -1;
+}
+
+bool SyntaxBlockData::isCurrent(uint hash, int length, int state, int gen, int revision) const
+{
+   return textHash == hash && textLength == length && prevState == state &&
+          generation == gen && spellRevision == revision;
+}
+
+// consecutive blocks for the parallel pass, every chunk assumes the normal start state
+struct SyntaxChunk
+{
+   int firstBlock;
+   QStringList textList;
+};
+
+struct SyntaxResultQueue
+{
+   std::mutex mutex;
+   QVector<SyntaxResult> resultList;
+
+   // requests not finished by the worker
+   std::atomic<int> pending;
+
+   // bumped by Syntax, jobs from an older generation are dropped unprocessed
+   std::atomic<int> generation;
+
+   // set when the Syntax is deleted
+   std::atomic<bool> isCancelled;
+
+   // parallel tokenizing of the whole document, the text is copied one chunk at a time by Syntax
+   std::condition_variable initialCondition;
+   std::deque<SyntaxChunk> initialChunks;
+
+   // every chunk was queued, running is the number of threads which have not returned
+   bool initialClosed;
+   int initialRunning;
+
+   // in the order the chunks finish
+   QVector<SyntaxResult> initialList;
+};
+
+struct SyntaxJob
+{
+   std::shared_ptr<SyntaxResultQueue> queue;
+   std::shared_ptr<const SyntaxDefinition> definition;
+
+   // null when spell check is off
+   SpellCheck *spellCheck;
+   int spellRevision;
+
+   int generation;
+   int firstBlock;
+   int prevState;
+   SyntaxMode mode;
+
+   // text of consecutive blocks, the end state of one is the start state of the next
+   QStringList textList;
+};
+
+static bool isStale(const SyntaxResultQueue &queue, int generation)
+{
+   return queue.isCancelled || queue.generation != generation;
+}
+
+// one thread shared by every Syntax, requests for visible blocks and edits go first
+class SyntaxWorker
+{
+   public:
+      static SyntaxWorker &instance();
+      ~SyntaxWorker();
+
+      void submit(SyntaxJob job, bool urgent);
+
+      // drops every queued job of a Syntax which is being deleted
+      void cancel(const SyntaxResultQueue *queue);
+
+      // runList must already be merged, the scope is taken from the comment and quote runs
+      static void spellRuns(SpellCheck *spellCheck, const SyntaxDefinition &definition, const QString &text,
+            QVector<SyntaxRun> &runList);
+
+      // runs for one block, merged so each character has at most one run
+      static int tokenizeBlock(const SyntaxDefinition &definition, SpellCheck *spellCheck, const QString &text,
+            int prevState, SyntaxMode mode, QVector<SyntaxRun> &runList);
+
+   private:
+      SyntaxWorker();
+      void run();
+
+      std::mutex m_mutex;
+      std::condition_variable m_condition;
+
+      std::deque<SyntaxJob> m_urgentList;
+      std::deque<SyntaxJob> m_backgroundList;
+      bool m_stop;
+
+      std::thread m_thread;
+};
+
+SyntaxWorker::SyntaxWorker()
+{
+   m_stop   = false;
+   m_thread = std::thread(&SyntaxWorker::run, this);
+}
+
+SyntaxWorker::~SyntaxWorker()
+{
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+   }
+
+   m_condition.notify_all();
+   m_thread.join();
+}
+
+SyntaxWorker &SyntaxWorker::instance()
+{
+   static SyntaxWorker worker;
+   return worker;
+}
+
+void SyntaxWorker::submit(SyntaxJob job, bool urgent)
+{
+   ++job.queue->pending;
+
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (urgent) {
+         m_urgentList.push_back(std::move(job));
+      } else {
+         m_backgroundList.push_back(std::move(job));
+      }
+   }
+
+   m_condition.notify_one();
+}
+
+void SyntaxWorker::cancel(const SyntaxResultQueue *queue)
+{
+   std::lock_guard<std::mutex> lock(m_mutex);
+
+   auto isOwned = [queue] (const SyntaxJob &job) {
+      return job.queue.get() == queue;
+   };
+
+   m_urgentList.erase(std::remove_if(m_urgentList.begin(), m_urgentList.end(), isOwned), m_urgentList.end());
+   m_backgroundList.erase(std::remove_if(m_backgroundList.begin(), m_backgroundList.end(), isOwned),
+         m_backgroundList.end());
+}
+
+void SyntaxWorker::run()
+{
+   while (true) {
+      SyntaxJob job;
+
+      {
+         std::unique_lock<std::mutex> lock(m_mutex);
+
+         m_condition.wait(lock, [this] ()
+               { return m_stop || ! m_urgentList.empty() || ! m_backgroundList.empty(); } );
+
+         if (m_stop) {
+            return;
+         }
+
+         std::deque<SyntaxJob> &list = m_urgentList.empty() ? m_backgroundList : m_urgentList;
+
+         job = std::move(list.front());
+         list.pop_front();
+      }
+
+      QVector<SyntaxResult> resultList;
+
+      // skipped when superseded by a new definition or the Syntax was deleted
+      if (! isStale(*job.queue, job.generation) && job.queue.use_count() > 1) {
+         int state  = job.prevState;
+         int number = job.firstBlock;
+
+         for (const QString &text : job.textList) {
+
+            if ((number & 0xFF) == 0 && isStale(*job.queue, job.generation)) {
+               break;
+            }
+
+            SyntaxResult result;
+
+            result.blockNumber   = number;
+            result.textHash      = qHash(text);
+            result.textLength    = text.length();
+            result.prevState     = state;
+            result.generation    = job.generation;
+            result.spellRevision = job.spellRevision;
+            result.endState      = tokenizeBlock(*job.definition, job.spellCheck, text, state, job.mode, result.runList);
+
+            state = result.endState;
+            ++number;
+
+            resultList.append(std::move(result));
+         }
+      }
+
+      std::lock_guard<std::mutex> lock(job.queue->mutex);
+
+      job.queue->resultList += resultList;
+      --job.queue->pending;
+   }
+}
+
+static void spellWord(SpellCheck *spellCheck, QStringView word, int offset, QVector<SyntaxRun> &runList)
+{
+   // split on underscores and case changes, fileName and HTMLParser are two words each
+   // a part containing a digit or a single letter is not checked
+
+   int index      = 0;
+   int partStart  = 0;
+   bool hasLetter = false;
+   bool hasDigit  = false;
+
+   QChar prev;
+
+   auto checkPart = [&] (int partEnd) {
+      int length = partEnd - partStart;
+
+      if (hasLetter && ! hasDigit && length > 1 && ! spellCheck->spell(word.mid(partStart, length))) {
+         runList.append( {offset + partStart, length, TOKEN_SPELL} );
+      }
+
+      hasLetter = false;
+      hasDigit  = false;
+   };
+
+   auto iter = word.begin();
+   auto end  = word.end();
+
+   while (iter != end) {
+      QChar c = *iter;
+      ++iter;
+
+      QChar next = (iter != end) ? *iter : QChar();
+
+      if (c == QChar('_')) {
+         checkPart(index);
+         partStart = index + 1;
+
+      } else {
+
+         if (c.isUpper() && index > partStart && (prev.isLower() || (prev.isUpper() && next.isLower()))) {
+            checkPart(index);
+            partStart = index;
+         }
+
+         if (c.isDigit()) {
+            hasDigit = true;
+
+         } else if (c.isLetter()) {
+            hasLetter = true;
+
+         }
+      }
+
+      prev = c;
+      ++index;
+   }
+
+   checkPart(index);
+}
+
+static void spellRange(SpellCheck *spellCheck, bool isSplit, const QString &text, int start, int length,
+      QVector<SyntaxRun> &runList)
+{
+   QString range = (start == 0 && length == text.length()) ? text : text.mid(start, length);
+
+   QTextBoundaryFinder wordFinder(QTextBoundaryFinder::Word, range);
+
+   while (wordFinder.position() < range.length()) {
+      int wordStart  = wordFinder.position();
+      int wordLength = wordFinder.toNextBoundary() - wordStart;
+
+      QStringView word = range.midView(wordStart, wordLength).trimmed();
+
+      if (isSplit) {
+         spellWord(spellCheck, word, start + wordStart, runList);
+
+      } else if ( ! spellCheck->spell(word) )   {
+         runList.append( {start + wordStart, wordLength, TOKEN_SPELL} );
+
+      }
+   }
+}
+
+void SyntaxWorker::spellRuns(SpellCheck *spellCheck, const SyntaxDefinition &definition, const QString &text,
+      QVector<SyntaxRun> &runList)
+{
+   bool isSplit = definition.isSpellSplit();
+
+   if (definition.spellScope() == SPELL_ALL) {
+      spellRange(spellCheck, isSplit, text, 0, text.length(), runList);
+      return;
+   }
+
+   int cnt = runList.size();
+
+   for (int k = 0; k < cnt; ++k) {
+      SyntaxRun run = runList[k];
+
+      if (run.token == TOKEN_QUOTE || run.token == TOKEN_COMMENT || run.token == TOKEN_MLINE) {
+         spellRange(spellCheck, isSplit, text, run.start, run.length, runList);
+      }
+   }
+}
+
+static void coalesceRuns(QVector<SyntaxRun> &runList, int length)
+{
+   // runs are applied in order and the last one wins, rules often overlap so resolve that here
+   // instead of calling setFormat() for every match
+   bool isOrdered = true;
+
+   for (int k = 1; k < runList.size(); ++k) {
+      if (runList[k].start < runList[k - 1].start + runList[k - 1].length) {
+         isOrdered = false;
+         break;
+      }
+   }
+
+   if (! isOrdered) {
+      std::vector<signed char> tokenList(length, -1);
+
+      for (const auto &run : runList) {
+         int first = std::max(run.start, 0);
+         int last  = std::min(run.start + run.length, length);
+
+         if (first < last) {
+            std::fill(tokenList.begin() + first, tokenList.begin() + last, static_cast<signed char>(run.token));
+         }
+      }
+
+      runList.clear();
+
+      int k = 0;
+
+      while (k < length) {
+         signed char token = tokenList[k];
+
+         if (token < 0) {
+            ++k;
+            continue;
+         }
+
+         int start = k;
+
+         while (k < length && tokenList[k] == token) {
+            ++k;
+         }
+
+         runList.append( {start, k - start, static_cast<SyntaxToken>(token)} );
+      }
+
+      return;
+   }
+
+   // already in text order, only join neighbours with the same token
+   int cnt = 0;
+
+   for (int k = 0; k < runList.size(); ++k) {
+      const SyntaxRun &run = runList[k];
+
+      if (run.length <= 0) {
+         continue;
+      }
+
+      if (cnt > 0) {
+         SyntaxRun &prev = runList[cnt - 1];
+
+         if (prev.token == run.token && prev.start + prev.length == run.start) {
+            prev.length += run.length;
+            continue;
+         }
+      }
+
+      runList[cnt] = run;
+      ++cnt;
+   }
+
+   runList.resize(cnt);
+}
+
+int SyntaxWorker::tokenizeBlock(const SyntaxDefinition &definition, SpellCheck *spellCheck, const QString &text,
+      int prevState, SyntaxMode mode, QVector<SyntaxRun> &runList)
+{
+   int retval = definition.tokenize(text, prevState, runList, mode);
+   coalesceRuns(runList, text.length());
+
+   if (spellCheck != nullptr) {
+      // misspelled words win over the syntax runs
+      spellRuns(spellCheck, definition, text, runList);
+      coalesceRuns(runList, text.length());
+   }
+
+   return retval;
+}
+
+static int nextGeneration()
+{
+   // unique across every Syntax, a new parser on the same document must not match runs left by the old one
+   static int generation = 0;
+
+   return ++generation;
+}
+
+static QVector<SyntaxResult> tokenizeChunk(const SyntaxResultQueue &queue, const SyntaxDefinition &definition,
+      SpellCheck *spellCheck, int spellRevision, int generation, SyntaxMode mode, const SyntaxChunk &chunk)
+{
+   QVector<SyntaxResult> retval;
+   retval.reserve(chunk.textList.size());
+
+   int state  = (chunk.firstBlock == 0) ? -1 : 0;
+   int number = chunk.firstBlock;
+
+   for (const QString &text : chunk.textList) {
+
+      if ((number & 0xFF) == 0 && isStale(queue, generation)) {
+         break;
+      }
+
+      SyntaxResult result;
+
+      result.blockNumber   = number;
+      result.textHash      = qHash(text);
+      result.textLength    = text.length();
+      result.prevState     = state;
+      result.generation    = generation;
+      result.spellRevision = spellRevision;
+      result.endState      = SyntaxWorker::tokenizeBlock(definition, spellCheck, text, state, mode, result.runList);
+
+      state = result.endState;
+      ++number;
+
+      retval.append(std::move(result));
+   }
+
+   return retval;
+}
+
+static void tokenizeInitial(std::shared_ptr<SyntaxResultQueue> queue, std::shared_ptr<const SyntaxDefinition> definition,
+      SpellCheck *spellCheck, int spellRevision, int generation, SyntaxMode mode)
+{
+   // one thread of the parallel pass, each has its own checker so the threads do not take turns on one hunspell
+   // checkers are kept by the main one and reused by the next pass
+   SpellCheck *checker = nullptr;
+
+   if (spellCheck != nullptr) {
+      checker = spellCheck->takeClone();
+   }
+
+   while (true) {
+      SyntaxChunk chunk;
+
+      {
+         std::unique_lock<std::mutex> lock(queue->mutex);
+
+         queue->initialCondition.wait(lock, [&queue, generation] ()
+               { return isStale(*queue, generation) || queue->initialClosed || ! queue->initialChunks.empty(); } );
+
+         if (isStale(*queue, generation) || queue->initialChunks.empty()) {
+            break;
+         }
+
+         chunk = std::move(queue->initialChunks.front());
+         queue->initialChunks.pop_front();
+      }
+
+      QVector<SyntaxResult> resultList = tokenizeChunk(*queue, *definition, checker, spellRevision,
+            generation, mode, chunk);
+
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      queue->initialList += resultList;
+   }
+
+   if (checker != nullptr) {
+      spellCheck->releaseClone(checker);
+   }
+
+   std::lock_guard<std::mutex> lock(queue->mutex);
+   --queue->initialRunning;
+}
+
+Syntax::Syntax(QTextDocument *document, QString synFName, const struct Settings &settings, SpellCheck *spell)
+   : QSyntaxHighlighter(document)
+{
+   m_syntaxFile   = synFName;
+   m_syntaxType   = SYN_NONE;
+   m_spellCheck   = spell;
+
+   m_isSpellCheck = settings.isSpellCheck;
+
+   setFormats(settings);
+
+   m_mode            = SYNTAX_FULL;
+   m_modeOverride    = SYNTAX_AUTO;
+   m_largeFileMode   = static_cast<SyntaxMode>(settings.largeFileMode);
+   m_largeFileSize   = qint64(settings.largeFileSize) * 1000 * 1000;
+   m_largeLineLength = settings.largeLineLength;
+
+   m_sliceBudget  = settings.syntaxSliceBudget;
+   m_nextBlock    = ALL_BLOCKS;
+   m_blockCount   = 0;
+
+   m_visibleFirst = -1;
+   m_visibleLast  = -1;
+   m_visibleDirty = false;
+
+   m_highlightTimer = new QTimer(this);
+   m_highlightTimer->setInterval(0);
+
+   m_resultQueue = std::make_shared<SyntaxResultQueue>();
+   m_resultQueue->pending      = 0;
+   m_resultQueue->generation   = 0;
+   m_resultQueue->isCancelled    = false;
+   m_resultQueue->initialClosed  = true;
+   m_resultQueue->initialRunning = 0;
+
+   m_generation     = 0;
+   m_initialPending = false;
+   m_initialNext    = 0;
+
+   m_resultTimer = new QTimer(this);
+   m_resultTimer->setInterval(2);
+
+   connect(m_highlightTimer, &QTimer::timeout,               this, &Syntax::highlightSlice);
+   connect(m_resultTimer,    &QTimer::timeout,               this, &Syntax::applyResults);
+   connect(document,         &QTextDocument::contentsChange, this, &Syntax::documentChanged);
+}
+
+Syntax::~Syntax()
+{
+   // stops the parallel pass and a job the worker is running, queued jobs are dropped now
+   m_resultQueue->isCancelled = true;
+   SyntaxWorker::instance().cancel(m_resultQueue.get());
+
+   stopInitial();
+}
+
+bool Syntax::processSyntax(const struct Settings &settings)
+{
+   // called when colors change, the runs cached in each block are applied with the new palette
+   setFormats(settings);
+
+   return processSyntax();
+}
+
+bool Syntax::processSyntax()
+{
+   // compiled once per syntax file and shared with every other tab
+   std::shared_ptr<const SyntaxDefinition> definition = SyntaxDefinition::get(m_syntaxFile, m_syntaxType);
+
+   if (! definition) {
+      return false;
+   }
+
+   bool isChanged = false;
+   SyntaxMode mode = chooseMode();
+
+   if (definition != m_definition || mode != m_mode) {
+      // runs cached in the blocks and requests still queued belong to the old definition
+      m_definition = definition;
+      m_mode       = mode;
+
+      m_generation = nextGeneration();
+      m_resultQueue->generation = m_generation;
+
+      // a parallel pass still running belongs to the old generation
+      stopInitial();
+      m_initialList.clear();
+
+      isChanged = true;
+   }
+
+   if (document()->characterCount() < SCHEDULE_MIN_SIZE) {
+      m_highlightTimer->stop();
+      m_nextBlock = ALL_BLOCKS;
+
+      // redo the current document
+      rehighlight();
+
+   } else {
+      // large document, highlight what is on screen now and the rest when idle
+      m_nextBlock    = 0;
+      m_blockCount   = document()->blockCount();
+      m_visibleDirty = true;
+
+      if (isChanged && m_mode != SYNTAX_NONE) {
+         startInitial();
+      }
+
+      m_highlightTimer->start();
+   }
+
+   return true;
+}
+
+void Syntax::startInitial()
+{
+   stopInitial();
+
+   {
+      std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+
+      m_resultQueue->initialChunks.clear();
+      m_resultQueue->initialList.clear();
+      m_resultQueue->initialClosed = false;
+   }
+
+   m_initialList.clear();
+   m_initialPending = true;
+   m_initialNext    = 0;
+
+   // a checker which is still loading passes every word, the results are redone once it is ready
+   SpellCheck *spellCheck = nullptr;
+
+   if (isSpellActive() && m_spellCheck->isLoaded()) {
+      spellCheck = m_spellCheck;
+   }
+
+   int chunkCount = (document()->blockCount() + INITIAL_CHUNK - 1) / INITIAL_CHUNK;
+
+   int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+   threads = std::max(std::min({threads, MAX_INITIAL_WORKERS, chunkCount}), 1);
+
+   {
+      std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+      m_resultQueue->initialRunning = threads;
+   }
+
+   for (int k = 0; k < threads; ++k) {
+      m_initialThreads.emplace_back(tokenizeInitial, m_resultQueue, m_definition, spellCheck, spellRevision(),
+            m_generation, m_mode);
+   }
+
+   feedInitial();
+}
+
+void Syntax::feedInitial()
+{
+   // block text is copied here since the document can not be read from another thread, only a few
+   // chunks are kept ahead of the threads so the whole document is never copied at once
+   QElapsedTimer timer;
+   timer.start();
+
+   int maxQueued = 2 * static_cast<int>(m_initialThreads.size());
+
+   QTextBlock block = document()->findBlockByNumber(m_initialNext);
+
+   while (block.isValid() && timer.elapsed() < m_sliceBudget) {
+
+      {
+         std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+
+         if (static_cast<int>(m_resultQueue->initialChunks.size()) >= maxQueued) {
+            return;
+         }
+      }
+
+      SyntaxChunk chunk;
+      chunk.firstBlock = m_initialNext;
+
+      for (int k = 0; k < INITIAL_CHUNK && block.isValid(); ++k) {
+         chunk.textList.append(block.text());
+
+         block = block.next();
+         ++m_initialNext;
+      }
+
+      {
+         std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+         m_resultQueue->initialChunks.push_back(std::move(chunk));
+      }
+
+      m_resultQueue->initialCondition.notify_one();
+   }
+
+   if (! block.isValid()) {
+      {
+         std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+         m_resultQueue->initialClosed = true;
+      }
+
+      m_resultQueue->initialCondition.notify_all();
+   }
+}
+
+void Syntax::stopInitial()
+{
+   // threads of an older generation return within a few hundred blocks, the others after their chunk
+   {
+      std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+
+      m_resultQueue->initialChunks.clear();
+      m_resultQueue->initialClosed = true;
+   }
+
+   m_resultQueue->initialCondition.notify_all();
+
+   for (auto &thread : m_initialThreads) {
+      thread.join();
+   }
+
+   m_initialThreads.clear();
+   m_initialPending = false;
+}
+
+void Syntax::useInitial(SyntaxBlockData *data, int blockNumber, uint textHash, int textLength)
+{
+   if (blockNumber >= m_initialList.size()) {
+      return;
+   }
+
+   SyntaxResult &result = m_initialList[blockNumber];
+
+   if (result.textHash != textHash || result.textLength != textLength ||
+         result.generation != m_generation || result.spellRevision != spellRevision()) {
+      return;
+   }
+
+   data->textHash      = result.textHash;
+   data->textLength    = result.textLength;
+   data->prevState     = result.prevState;
+   data->generation    = result.generation;
+   data->spellRevision = result.spellRevision;
+   data->endState      = result.endState;
+   data->runList       = std::move(result.runList);
+
+   // used once
+   result.textHash   = 0;
+   result.textLength = -1;
+}
+
+void Syntax::forceTokenize()
+{
+   // drop the runs cached in the blocks, used by the profiler to measure the whole document
+   m_definition.reset();
+
+   processSyntax();
+}
+
+void Syntax::setFormats(const struct Settings &settings)
+{
+   m_formatList.resize(TOKEN_COUNT);
+
+   m_formatList[TOKEN_KEY].setFontWeight(settings.syn_KeyWeight);
+   m_formatList[TOKEN_KEY].setFontItalic(settings.syn_KeyItalic);
+   m_formatList[TOKEN_KEY].setForeground(settings.syn_KeyText);
+
+   m_formatList[TOKEN_CLASS].setFontWeight(settings.syn_ClassWeight);
+   m_formatList[TOKEN_CLASS].setFontItalic(settings.syn_ClassItalic);
+   m_formatList[TOKEN_CLASS].setForeground(settings.syn_ClassText);
+
+   m_formatList[TOKEN_FUNC].setFontWeight(settings.syn_FuncWeight);
+   m_formatList[TOKEN_FUNC].setFontItalic(settings.syn_FuncItalic);
+   m_formatList[TOKEN_FUNC].setForeground(settings.syn_FuncText);
+
+   m_formatList[TOKEN_TYPE].setFontWeight(settings.syn_TypeWeight);
+   m_formatList[TOKEN_TYPE].setFontItalic(settings.syn_TypeItalic);
+   m_formatList[TOKEN_TYPE].setForeground(settings.syn_TypeText);
+
+   m_formatList[TOKEN_QUOTE].setFontWeight(settings.syn_QuoteWeight);
+   m_formatList[TOKEN_QUOTE].setFontItalic(settings.syn_QuoteItalic);
+   m_formatList[TOKEN_QUOTE].setForeground(settings.syn_QuoteText);
+
+   m_formatList[TOKEN_COMMENT].setFontWeight(settings.syn_CommentWeight);
+   m_formatList[TOKEN_COMMENT].setFontItalic(settings.syn_CommentItalic);
+   m_formatList[TOKEN_COMMENT].setForeground(settings.syn_CommentText);
+
+   m_formatList[TOKEN_MLINE].setFontWeight(settings.syn_MLineWeight);
+   m_formatList[TOKEN_MLINE].setFontItalic(settings.syn_MLineItalic);
+   m_formatList[TOKEN_MLINE].setForeground(settings.syn_MLineText);
+
+   // spell check
+   m_formatList[TOKEN_SPELL].setUnderlineColor(QColor(Qt::red));
+
+   // pending CS 1.6.1
+   // m_formatList[TOKEN_SPELL].setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+   m_formatList[TOKEN_SPELL].setUnderlineStyle(QTextCharFormat::WaveUnderline);
+}
+
+void Syntax::set_Spell(bool value)
+{
+   if (m_isSpellCheck != value) {
+      // cached runs include the spelling errors
+      m_isSpellCheck = value;
+
+      m_generation = nextGeneration();
+      m_resultQueue->generation = m_generation;
+   }
+}
+
+bool Syntax::isSpellActive() const
+{
+   // spell check is off in the degraded modes
+   return m_spellCheck && m_isSpellCheck && m_mode == SYNTAX_FULL;
+}
+
+int Syntax::spellRevision() const
+{
+   if (isSpellActive()) {
+      return m_spellCheck->revision();
+   }
+
+   return -1;
+}
+
+void Syntax::set_SyntaxType(SyntaxTypes type)
+{
+   m_syntaxType = type;
+}
+
+std::shared_ptr<const SyntaxDefinition> Syntax::get_Definition() const
+{
+   return m_definition;
+}
+
+int Syntax::spellBlock(const SyntaxDefinition *definition, SpellCheck *spellCheck, const QString &text,
+      int prevState, QVector<SyntaxRun> &runList)
+{
+   if (definition == nullptr) {
+      spellRange(spellCheck, true, text, 0, text.length(), runList);
+      return 0;
+   }
+
+   if (definition->spellScope() == SPELL_ALL) {
+      // no need to tokenize when every word is checked
+      spellRange(spellCheck, definition->isSpellSplit(), text, 0, text.length(), runList);
+      return 0;
+   }
+
+   int retval = SyntaxWorker::tokenizeBlock(*definition, spellCheck, text, prevState, SYNTAX_FULL, runList);
+
+   runList.erase(std::remove_if(runList.begin(), runList.end(),
+         [] (const SyntaxRun &run) { return run.token != TOKEN_SPELL; } ), runList.end());
+
+   return retval;
+}
+
+void Syntax::set_ModeOverride(SyntaxMode mode)
+{
+   m_modeOverride = mode;
+}
+
+SyntaxMode Syntax::get_Mode() const
+{
+   return m_mode;
+}
+
+SyntaxMode Syntax::chooseMode() const
+{
+   if (m_modeOverride != SYNTAX_AUTO) {
+      return m_modeOverride;
+   }
+
+   // characters, not bytes
+   if (document()->characterCount() > m_largeFileSize) {
+      return m_largeFileMode;
+   }
+
+   for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+      if (block.length() > m_largeLineLength) {
+         return m_largeFileMode;
+      }
+   }
+
+   return SYNTAX_FULL;
+}
+
+void Syntax::setVisibleBlocks(int first, int last)
+{
+   if (first == m_visibleFirst && last == m_visibleLast) {
+      return;
+   }
+
+   m_visibleFirst = first;
+   m_visibleLast  = last;
+
+   if (m_nextBlock != ALL_BLOCKS) {
+      // picked up by the next slice
+      m_visibleDirty = true;
+   }
+}
+
+bool Syntax::isAdmitted(int blockNumber) const
+{
+   return blockNumber < m_nextBlock || isVisible(blockNumber);
+}
+
+bool Syntax::isVisible(int blockNumber) const
+{
+   return blockNumber >= m_visibleFirst && blockNumber <= m_visibleLast;
+}
+
+void Syntax::highlightSlice()
+{
+   QTextDocument *doc = document();
+
+   if (doc == nullptr || ! m_definition) {
+      m_highlightTimer->stop();
+      stopInitial();
+
+      return;
+   }
+
+   if (m_visibleDirty) {
+      m_visibleDirty = false;
+
+      // out of order, the state of the previous block may still be wrong until the pass reaches it
+      int number = std::max(m_visibleFirst, m_nextBlock);
+      QTextBlock block = doc->findBlockByNumber(number);
+
+      while (block.isValid() && number <= m_visibleLast) {
+         rehighlightBlock(block);
+
+         block = block.next();
+         ++number;
+      }
+   }
+
+   if (m_initialPending) {
+      feedInitial();
+
+      QVector<SyntaxResult> resultList;
+
+      {
+         std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+
+         if (! m_resultQueue->initialClosed || ! m_resultQueue->initialChunks.empty() ||
+               m_resultQueue->initialRunning > 0) {
+            // parallel pass still running, only the visible blocks go to the worker
+            return;
+         }
+
+         resultList.swap(m_resultQueue->initialList);
+      }
+
+      stopInitial();
+
+      // a chunk which started inside a multi line comment has the wrong start state, highlightBlock()
+      // sends those blocks to the worker the same as blocks whose start state changed after an edit
+      int size = 0;
+
+      for (const auto &result : resultList) {
+         size = std::max(size, result.blockNumber + 1);
+      }
+
+      m_initialList.resize(size);
+
+      for (auto &result : resultList) {
+         m_initialList[result.blockNumber] = std::move(result);
+      }
+   }
+
+   if (m_resultQueue->pending > MAX_PENDING) {
+      // let the worker catch up
+      return;
+   }
+
+   QElapsedTimer timer;
+   timer.start();
+
+   QTextBlock block = doc->findBlockByNumber(m_nextBlock);
+
+   while (block.isValid()) {
+      ++m_nextBlock;
+      rehighlightBlock(block);
+
+      block = block.next();
+
+      if (timer.elapsed() >= m_sliceBudget) {
+         break;
+      }
+   }
+
+   if (! block.isValid()) {
+      m_nextBlock = ALL_BLOCKS;
+      m_highlightTimer->stop();
+
+      m_initialList.clear();
+   }
+}
+
+void Syntax::documentChanged(int position, int, int)
+{
+   if (m_nextBlock == ALL_BLOCKS) {
+      return;
+   }
+
+   // lines added or removed ahead of the background pass shift the blocks it has not reached
+   int count = document()->blockCount();
+   int delta = count - m_blockCount;
+
+   m_blockCount = count;
+
+   if (delta != 0) {
+      int number = document()->findBlock(position).blockNumber();
+
+      if (number < m_nextBlock) {
+         m_nextBlock = std::max(m_nextBlock + delta, number);
+      }
+   }
+}
+
+void Syntax::requestBlocks(const QTextBlock &block, int prevState, int count, bool urgent)
+{
+   SyntaxJob job;
+
+   job.queue         = m_resultQueue;
+   job.definition    = m_definition;
+   job.spellCheck    = isSpellActive() ? m_spellCheck : nullptr;
+   job.spellRevision = spellRevision();
+   job.generation    = m_generation;
+   job.firstBlock    = block.blockNumber();
+   job.prevState     = prevState;
+   job.mode          = m_mode;
+
+   QTextBlock next = block;
+
+   for (int k = 0; k < count && next.isValid(); ++k) {
+      job.textList.append(next.text());
+      next = next.next();
+   }
+
+   SyntaxWorker::instance().submit(std::move(job), urgent);
+
+   if (! m_resultTimer->isActive()) {
+      m_resultTimer->start();
+   }
+}
+
+void Syntax::applyResults()
+{
+   QVector<SyntaxResult> resultList;
+
+   {
+      std::lock_guard<std::mutex> lock(m_resultQueue->mutex);
+      resultList.swap(m_resultQueue->resultList);
+   }
+
+   if (resultList.isEmpty() && m_resultQueue->pending == 0) {
+      m_resultTimer->stop();
+      return;
+   }
+
+   QTextDocument *doc = document();
+
+   if (doc == nullptr) {
+      return;
+   }
+
+   // store every result first, a chain is then applied by one cascade in rehighlightBlock
+   QVector<QTextBlock> blockList;
+
+   for (auto &result : resultList) {
+
+      if (result.generation != m_generation || result.spellRevision != spellRevision()) {
+         continue;
+      }
+
+      QTextBlock block = doc->findBlockByNumber(result.blockNumber);
+
+      if (! block.isValid()) {
+         continue;
+      }
+
+      QString text = block.text();
+
+      if (qHash(text) != result.textHash || text.length() != result.textLength) {
+         // edited since the request was made
+         continue;
+      }
+
+      SyntaxBlockData *data = dynamic_cast<SyntaxBlockData *>(block.userData());
+
+      if (data == nullptr) {
+         data = new SyntaxBlockData;
+         block.setUserData(data);
+      }
+
+      data->textHash      = result.textHash;
+      data->textLength    = result.textLength;
+      data->prevState     = result.prevState;
+      data->generation    = result.generation;
+      data->spellRevision = result.spellRevision;
+      data->endState      = result.endState;
+      data->runList       = std::move(result.runList);
+      data->isApplied     = false;
+
+      blockList.append(block);
+   }
+
+   for (const auto &block : blockList) {
+      SyntaxBlockData *data = static_cast<SyntaxBlockData *>(block.userData());
+
+      if (! data->isApplied && data->prevState == block.previous().userState()) {
+         rehighlightBlock(block);
+      }
+   }
+}
+
+void Syntax::highlightBlock(const QString &text)
+{
+   if (! m_definition) {
+      return;
+   }
+
+   int blockNumber = currentBlock().blockNumber();
+
+   if (m_nextBlock != ALL_BLOCKS && ! isAdmitted(blockNumber)) {
+      // not reached by the background pass, keep the state so the change stops here
+      setCurrentBlockState(currentBlockState());
+      return;
+   }
+
+   if (m_mode == SYNTAX_NONE) {
+      // large file, formats are cleared and nothing is tokenized
+      setCurrentBlockState(0);
+      return;
+   }
+
+   int prevState = previousBlockState();
+   uint textHash = qHash(text);
+   int revision  = spellRevision();
+
+   SyntaxBlockData *data = dynamic_cast<SyntaxBlockData *>(currentBlockUserData());
+
+   if (data == nullptr) {
+      data = new SyntaxBlockData;
+      setCurrentBlockUserData(data);
+   }
+
+   if (! data->isCurrent(textHash, text.length(), prevState, m_generation, revision) && ! m_initialList.isEmpty()) {
+      useInitial(data, blockNumber, textHash, text.length());
+   }
+
+   // runs from the last result, stale ones are shown until the worker replies
+   // runs do not overlap so each range is set once with the shared format of its token
+   for (const auto &run : data->runList) {
+      setFormat(run.start, run.length, m_formatList[run.token]);
+   }
+
+   if (data->isCurrent(textHash, text.length(), prevState, m_generation, revision)) {
+      data->isApplied = true;
+      setCurrentBlockState(data->endState);
+
+      return;
+   }
+
+   // keep the old state until the result arrives, the cascade continues from there
+   setCurrentBlockState(currentBlockState());
+
+   if (data->requestHash != textHash || data->requestState != prevState ||
+         data->requestGeneration != m_generation || data->requestRevision != revision) {
+
+      data->requestHash       = textHash;
+      data->requestState      = prevState;
+      data->requestGeneration = m_generation;
+      data->requestRevision   = revision;
+
+      // only the start state changed, a comment was opened or closed above so ask for the following blocks too
+      bool isCascade = data->textHash == textHash && data->textLength == text.length() && data->generation == m_generation;
+
+      bool urgent = (m_nextBlock == ALL_BLOCKS) || isVisible(blockNumber);
+      requestBlocks(currentBlock(), prevState, isCascade ? CHAIN_SIZE : 1, urgent);
+   }
+}
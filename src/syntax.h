@@ -17,14 +17,220 @@
 
 #include "settings.h"
 #include "spellcheck.h"
+#include "syntax_lexer.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QDateTime>
 #include <QHash>
+#include <QJsonArray>
 #include <QPlainTextEdit>
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <QRegularExpression>
+#include <QStringList>
+#include <QTextBlock>
+#include <QTimer>
 #include <QVector>
 
+// spell check the whole block or only the comments and quoted text
+enum SpellScope { SPELL_ALL, SPELL_COMMENTS };
+
+// compiled rules for one syntax file, shared by every tab which uses the file
+class SyntaxDefinition
+{
+   public:
+      // quotes and comments of the built in languages are scanned by a native lexer unless the
+      // syntax file sets native-lexer to false
+      static std::shared_ptr<const SyntaxDefinition> get(const QString &fileName, SyntaxTypes type = SYN_NONE);
+
+      // compiled definitions are saved in this file, keyed by syntax file path, size and modified time
+      static void setCacheFile(const QString &fileName);
+
+      // runs are returned in the order they are applied, the last run wins, returns the block state
+      // keyword mode only uses the literal word tables and does not track multi line comments
+      int tokenize(const QString &text, int prevState, QVector<SyntaxRun> &runList,
+            SyntaxMode mode = SYNTAX_FULL) const;
+
+      // set by spell-scope in the syntax file, plain text and markup default to the whole block
+      SpellScope spellScope() const;
+
+      // identifiers like fileName or file_name are checked one part at a time
+      bool isSpellSplit() const;
+
+      // instrumentation, while enabled every pass of every loaded definition is timed
+      static void setProfiling(bool enable);
+      static bool isProfiling();
+      static void resetProfile();
+      static QJsonArray profileReport();
+
+   private:
+      SyntaxDefinition();
+
+      struct HighlightingRule
+      {
+         QRegularExpression pattern;
+         SyntaxToken token;
+      };
+
+      // one regex scan per pass, a pass holds a single rule or a keyword table built from a run
+      // of literal word rules like \bclass\b
+      struct HighlightingPass
+      {
+         QRegularExpression pattern;
+         QVector<int> ruleList;
+
+         QHash<QString, int> keywords;
+      };
+
+      struct HighlightMatch
+      {
+         int start;
+         int length;
+         int rule;
+      };
+
+      struct HighlightWord
+      {
+         int start;
+         int length;
+         QString text;
+      };
+
+      // a pass can only match when the block contains one of these literals, checked before the regex runs
+      struct PassFilter
+      {
+         bool isActive;
+         bool ignoreCase;
+
+         // first byte of every literal, both cases when the pass ignores case
+         QVector<QByteArray> literalList;
+         QByteArray firstList;
+      };
+
+      // times are in nanoseconds, the worst time is for a single block
+      struct PassProfile
+      {
+         qint64 calls;
+         qint64 totalTime;
+         qint64 worstTime;
+      };
+
+      QString m_syntaxFile;
+      qint64 m_fileSize;
+      QDateTime m_lastModified;
+
+      bool m_ignoreCase;
+      bool m_isNative;
+
+      SyntaxLexerType m_lexer;
+
+      QString m_spellScopeName;
+      SpellScope m_spellScope;
+      bool m_isSpellSplit;
+
+      QRegularExpression m_commentStartExpression;
+      QRegularExpression m_commentEndExpression;
+
+      QVector<HighlightingRule> highlightingRules;
+      QVector<HighlightingPass> highlightingPasses;
+
+      // one per pass, built after loading and not saved in the cache
+      QVector<PassFilter> m_filterList;
+      PassFilter m_commentFilter;
+
+      void buildFilters();
+      PassFilter makeFilter(const QVector<QRegularExpression> &patternList) const;
+
+      static QByteArray requiredLiteral(const QString &pattern);
+      static bool isPossible(const PassFilter &filter, const unsigned char *data, int size);
+
+      static QHash<QString, std::shared_ptr<const SyntaxDefinition>> m_registry;
+
+      // one entry per pass, the last one is the multi line comment
+      static std::atomic<bool> m_profiling;
+      mutable std::mutex m_profileMutex;
+      mutable QVector<PassProfile> m_passProfile;
+      mutable QVector<qint64> m_ruleHits;
+
+      // per rule, patterns likely to backtrack badly
+      QStringList m_warningList;
+
+      void checkRules();
+      static QString checkPattern(const QString &pattern);
+
+      void recordProfile(const QVector<PassProfile> &passProfile, const QVector<qint64> &ruleHits) const;
+
+      static QString m_cacheFile;
+      static QHash<QString, QByteArray> m_cacheList;
+      static bool m_cacheLoaded;
+
+      static void cacheLoad();
+      static void cacheSave();
+
+      bool cacheRead();
+      void cacheWrite() const;
+
+      bool processSyntax(const QByteArray &data);
+      void addRules(const QJsonArray &list, SyntaxToken token, bool ignoreCase);
+      void buildPasses(bool ignoreCase);
+
+      bool isPassValid(const HighlightingPass &pass) const;
+
+      // the word of a rule like \bclass\b, empty for any other pattern
+      static QString literalWord(const QString &pattern);
+      static QByteArray json_ReadFile(QString fileName);
+
+      bool isLexical(const HighlightingPass &pass) const;
+      void findWords(const QString &text, QVector<HighlightWord> &wordList) const;
+};
+
+// tokenized block returned by the worker thread
+struct SyntaxResult
+{
+   int blockNumber;
+   uint textHash;
+   int textLength;
+   int prevState;
+   int endState;
+   int generation;
+   int spellRevision;
+
+   // in text order and not overlapping
+   QVector<SyntaxRun> runList;
+};
+
+// runs computed by the worker thread for one block, valid while the key matches the block
+class SyntaxBlockData : public QTextBlockUserData
+{
+   public:
+      SyntaxBlockData();
+
+      bool isCurrent(uint hash, int length, int state, int generation, int spellRevision) const;
+
+      uint textHash;
+      int textLength;
+      int prevState;
+      int generation;
+      int spellRevision;
+
+      int endState;
+      QVector<SyntaxRun> runList;
+      bool isApplied;
+
+      // last request sent to the worker, avoids asking twice for the same block
+      uint requestHash;
+      int requestState;
+      int requestGeneration;
+      int requestRevision;
+};
+
+struct SyntaxResultQueue;
+
 class Syntax : public QSyntaxHighlighter
 {
    CS_OBJECT(Syntax)
@@ -36,34 +242,95 @@ class Syntax : public QSyntaxHighlighter
       ~Syntax();
       bool processSyntax();
       bool processSyntax(const struct Settings &settings);
+      void forceTokenize();
       void set_Spell(bool value);
 
+      // blocks on screen, highlighted ahead of the background pass
+      void setVisibleBlocks(int first, int last);
+
+      // selects the native lexer, set before processSyntax()
+      void set_SyntaxType(SyntaxTypes type);
+
+      // null until processSyntax() has loaded the syntax file
+      std::shared_ptr<const SyntaxDefinition> get_Definition() const;
+
+      // spell check one block outside of the highlighter, only the misspelled words are returned
+      // with a null definition every word is checked, returns the block state
+      static int spellBlock(const SyntaxDefinition *definition, SpellCheck *spellCheck, const QString &text,
+            int prevState, QVector<SyntaxRun> &runList);
+
+      // SYNTAX_AUTO applies the large file policy
+      void set_ModeOverride(SyntaxMode mode);
+      SyntaxMode get_Mode() const;
+
    protected:
       void highlightBlock(const QString &text);
 
    private:
       QString m_syntaxFile;
-      struct Settings m_settings;
+      SyntaxTypes m_syntaxType;
+      std::shared_ptr<const SyntaxDefinition> m_definition;
 
       SpellCheck *m_spellCheck;
       bool m_isSpellCheck;
 
-      QRegularExpression m_commentStartExpression;
-      QRegularExpression m_commentEndExpression;
+      // indexed by SyntaxToken
+      QVector<QTextCharFormat> m_formatList;
 
-      QTextCharFormat m_multiLineCommentFormat;
-      QTextCharFormat m_spellCheckFormat;
+      // large file policy
+      SyntaxMode m_mode;
+      SyntaxMode m_modeOverride;
+      SyntaxMode m_largeFileMode;
+      qint64 m_largeFileSize;
+      int m_largeLineLength;
 
-      QByteArray json_ReadFile(QString fileName);
+      SyntaxMode chooseMode() const;
+      bool isSpellActive() const;
 
-      //
-      struct HighlightingRule
-      {
-         QRegularExpression pattern;
-         QTextCharFormat format;
-      };
+      void setFormats(const struct Settings &settings);
+
+      // large documents are highlighted in time slices, blocks before m_nextBlock are done
+      QTimer *m_highlightTimer;
+      int m_sliceBudget;
+      int m_nextBlock;
+      int m_blockCount;
+
+      int m_visibleFirst;
+      int m_visibleLast;
+      bool m_visibleDirty;
+
+      bool isAdmitted(int blockNumber) const;
+      bool isVisible(int blockNumber) const;
+
+      // tokenizing is done on a worker thread, results are polled and applied to the blocks
+      std::shared_ptr<SyntaxResultQueue> m_resultQueue;
+      QTimer *m_resultTimer;
+      int m_generation;
+
+      // large documents are first tokenized in parallel, indexed by block number
+      QVector<SyntaxResult> m_initialList;
+      bool m_initialPending;
+
+      // next block to copy for the parallel pass, the threads are joined before a new pass starts
+      int m_initialNext;
+      std::vector<std::thread> m_initialThreads;
+
+      void startInitial();
+      void feedInitial();
+      void stopInitial();
+      void useInitial(SyntaxBlockData *data, int blockNumber, uint textHash, int textLength);
+
+      int spellRevision() const;
+      void requestBlocks(const QTextBlock &block, int prevState, int count, bool urgent);
+
+      CS_SLOT_1(Private, void applyResults())
+      CS_SLOT_2(applyResults)
+
+      CS_SLOT_1(Private, void highlightSlice())
+      CS_SLOT_2(highlightSlice)
 
-      QVector<HighlightingRule> highlightingRules;     
+      CS_SLOT_1(Private, void documentChanged(int position, int charsRemoved, int charsAdded))
+      CS_SLOT_2(documentChanged)
 };
 
 #endif
@@ -0,0 +1,750 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#include "syntax_lexer.h"
+
+#include <array>
+#include <cstring>
+
+// block states, 1 is also the multi line comment state of the regex highlighter
+enum LexerState {
+   STATE_NORMAL        = 0,
+   STATE_COMMENT       = 1,
+   STATE_STRING        = 2,     // double quoted string continued by a trailing backslash
+   STATE_TRIPLE_DOUBLE = 3,     // python """ or java text block
+   STATE_TRIPLE_SINGLE = 4,     // python '''
+   STATE_TEMPLATE      = 5,     // js template literal
+   STATE_CDATA         = 6,
+   STATE_TAG           = 7,     // inside an xml tag
+   STATE_SHELL_SINGLE  = 8,
+   STATE_SHELL_DOUBLE  = 9,
+   STATE_RAW           = 10,    // c++ raw string, a hash of the delimiter is kept above STATE_MASK
+};
+
+static const int STATE_MASK = 0xff;
+
+static const int MAX_RAW_DELIMITER = 16;
+
+using CharTable = std::array<bool, 256>;
+
+static constexpr CharTable makeTable(const char *list)
+{
+   CharTable table = {};
+
+   for (const char *c = list; *c != '\0'; ++c) {
+      table[static_cast<unsigned char>(*c)] = true;
+   }
+
+   return table;
+}
+
+static constexpr CharTable makeIdentTable()
+{
+   CharTable table = {};
+
+   for (int c = 0; c < 256; ++c) {
+      // any byte of a multi byte character is part of an identifier
+      table[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c >= 0x80;
+   }
+
+   return table;
+}
+
+static constexpr CharTable IDENT_CHARS = makeIdentTable();
+static constexpr CharTable SHELL_BREAK = makeTable(" \t;|&()");
+
+// bytes which can start a quote or comment, everything else is skipped with one table lookup
+static constexpr CharTable C_STOP        = makeTable("\"'/");
+static constexpr CharTable JS_STOP       = makeTable("\"'/`");
+static constexpr CharTable JSON_STOP     = makeTable("\"/");
+static constexpr CharTable PYTHON_STOP   = makeTable("#\"'");
+static constexpr CharTable SHELL_STOP    = makeTable("#\"'\\");
+static constexpr CharTable XML_TEXT_STOP = makeTable("<");
+static constexpr CharTable XML_TAG_STOP  = makeTable("\"'>");
+
+// a js regex literal can follow these, after anything else a slash is a division
+static constexpr CharTable JS_REGEX_PREV = makeTable("(,=:[!&|?{};~+-*%<>^");
+
+// works on the utf-8 bytes of the block, every delimiter is ascii so nothing is decoded
+struct LexScanner
+{
+   LexScanner(const QString &text, QVector<SyntaxRun> &runList)
+      : m_data(reinterpret_cast<const unsigned char *>(text.constData())), m_size(text.size_storage()),
+        m_runList(runList), m_bytePos(0), m_charPos(0)
+   {
+   }
+
+   unsigned char at(int pos) const {
+      return pos < m_size ? m_data[pos] : 0;
+   }
+
+   bool startsWith(int pos, const char *str) const {
+      int len = std::strlen(str);
+      return pos + len <= m_size && std::memcmp(m_data + pos, str, len) == 0;
+   }
+
+   int skipTo(int pos, const CharTable &stop) const {
+      while (pos < m_size && ! stop[m_data[pos]]) {
+         ++pos;
+      }
+
+      return pos;
+   }
+
+   // returns the position after close, -1 when the block ends first
+   int find(int pos, const char *close, bool isEscaped) const {
+      int len = std::strlen(close);
+
+      while (pos < m_size) {
+
+         if (! isEscaped) {
+            const void *next = std::memchr(m_data + pos, close[0], m_size - pos);
+
+            if (next == nullptr) {
+               return -1;
+            }
+
+            pos = static_cast<const unsigned char *>(next) - m_data;
+
+         } else if (m_data[pos] == '\\') {
+            pos += 2;
+            continue;
+
+         }
+
+         if (startsWith(pos, close)) {
+            return pos + len;
+         }
+
+         ++pos;
+      }
+
+      return -1;
+   }
+
+   // odd number of trailing backslashes, the line continues on the next block
+   bool isContinued() const {
+      int cnt = 0;
+
+      while (cnt < m_size && m_data[m_size - 1 - cnt] == '\\') {
+         ++cnt;
+      }
+
+      return (cnt % 2) == 1;
+   }
+
+   // C++14 digit separator as in 1'000'000
+   bool isDigitSeparator(int pos) const {
+      int start = pos;
+
+      while (start > 0 && IDENT_CHARS[m_data[start - 1]]) {
+         --start;
+      }
+
+      return start < pos && m_data[start] >= '0' && m_data[start] <= '9';
+   }
+
+   // length of an R, u8R, uR, UR or LR prefix just before the quote, 0 if there is none
+   int rawPrefix(int pos) const {
+      if (pos < 1 || m_data[pos - 1] != 'R') {
+         return 0;
+      }
+
+      int start = pos - 1;
+
+      if (start >= 2 && m_data[start - 2] == 'u' && m_data[start - 1] == '8') {
+         start -= 2;
+
+      } else if (start >= 1 && (m_data[start - 1] == 'u' || m_data[start - 1] == 'U' || m_data[start - 1] == 'L')) {
+         start -= 1;
+
+      }
+
+      if (start > 0 && IDENT_CHARS[m_data[start - 1]]) {
+         return 0;
+      }
+
+      return pos - start;
+   }
+
+   // a slash where an expression can start opens a js regex literal, after a value it is a division
+   bool isRegexStart(int pos) const {
+      int prev = pos;
+
+      while (prev > 0 && (m_data[prev - 1] == ' ' || m_data[prev - 1] == '\t')) {
+         --prev;
+      }
+
+      if (prev == 0) {
+         return true;
+      }
+
+      unsigned char c = m_data[prev - 1];
+
+      if (IDENT_CHARS[c]) {
+         int start = prev - 1;
+
+         while (start > 0 && IDENT_CHARS[m_data[start - 1]]) {
+            --start;
+         }
+
+         static const char *keywordList[] = { "return", "typeof", "instanceof", "in", "of", "new", "delete",
+               "void", "throw", "case", "do", "else", "yield", "await" };
+
+         for (const char *keyword : keywordList) {
+            int len = std::strlen(keyword);
+
+            if (prev - start == len && std::memcmp(m_data + start, keyword, len) == 0) {
+               return true;
+            }
+         }
+
+         return false;
+      }
+
+      if ((c == '+' || c == '-') && prev >= 2 && m_data[prev - 2] == c) {
+         // postfix increment or decrement
+         return false;
+      }
+
+      return c == '}' || JS_REGEX_PREV[c];
+   }
+
+   // position after the closing slash and the flags, -1 when the block ends first
+   int findRegex(int pos) const {
+      bool isClass = false;
+
+      ++pos;
+
+      while (pos < m_size) {
+         unsigned char c = m_data[pos];
+
+         if (c == '\\') {
+            pos += 2;
+            continue;
+         }
+
+         if (isClass) {
+            isClass = (c != ']');
+
+         } else if (c == '[') {
+            isClass = true;
+
+         } else if (c == '/') {
+            ++pos;
+
+            while (pos < m_size && IDENT_CHARS[m_data[pos]]) {
+               ++pos;
+            }
+
+            return pos;
+         }
+
+         ++pos;
+      }
+
+      return -1;
+   }
+
+   int rawHash(int begin, int end) const {
+      unsigned int hash = 2166136261u;
+
+      for (int k = begin; k < end; ++k) {
+         hash = (hash ^ m_data[k]) * 16777619u;
+      }
+
+      return (hash ^ (hash >> 16)) & 0xffff;
+   }
+
+   bool isRawDelimiter(unsigned char c) const {
+      return c > ' ' && c != '(' && c != ')' && c != '\\' && c != '"';
+   }
+
+   // position after )delimiter", -1 when the block ends first
+   int findRaw(int pos, int delimiterHash) const {
+      while (true) {
+         pos = find(pos, ")", false);
+
+         if (pos < 0) {
+            return -1;
+         }
+
+         int end = pos;
+
+         while (end < m_size && end - pos < MAX_RAW_DELIMITER && isRawDelimiter(m_data[end])) {
+            ++end;
+         }
+
+         if (at(end) == '"' && rawHash(pos, end) == delimiterHash) {
+            return end + 1;
+         }
+      }
+   }
+
+   void addRun(int begin, int end, SyntaxToken token) {
+      int first = charIndex(begin);
+      int last  = charIndex(end);
+
+      if (last > first) {
+         m_runList.append( {first, last - first, token} );
+      }
+   }
+
+   // runs are added in text order so the count only moves forward
+   int charIndex(int pos) {
+      if (pos < m_bytePos) {
+         m_bytePos = 0;
+         m_charPos = 0;
+      }
+
+      while (m_bytePos < pos) {
+         if ((m_data[m_bytePos] & 0xc0) != 0x80) {
+            ++m_charPos;
+         }
+
+         ++m_bytePos;
+      }
+
+      return m_charPos;
+   }
+
+   const unsigned char *m_data;
+   int m_size;
+
+   QVector<SyntaxRun> &m_runList;
+   int m_bytePos;
+   int m_charPos;
+};
+
+// adds the run from begin through close, returns -1 when the block ends first
+static int addClosed(LexScanner &scan, int begin, int from, const char *close, bool isEscaped, SyntaxToken token)
+{
+   int end = scan.find(from, close, isEscaped);
+
+   if (end < 0) {
+      scan.addRun(begin, scan.m_size, token);
+      return -1;
+   }
+
+   scan.addRun(begin, end, token);
+
+   return end;
+}
+
+static int tokenizeC(LexScanner &scan, int prevState, SyntaxLexerType type)
+{
+   const CharTable &stop = (type == LEXER_JS) ? JS_STOP : (type == LEXER_JSON) ? JSON_STOP : C_STOP;
+
+   int pos = 0;
+
+   // finish what the previous block left open
+   switch (prevState & STATE_MASK) {
+      case STATE_COMMENT:
+         pos = addClosed(scan, 0, 0, "*/", false, TOKEN_MLINE);
+
+         if (pos < 0) {
+            return STATE_COMMENT;
+         }
+
+         break;
+
+      case STATE_STRING:
+         pos = addClosed(scan, 0, 0, "\"", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return scan.isContinued() ? STATE_STRING : STATE_NORMAL;
+         }
+
+         break;
+
+      case STATE_TRIPLE_DOUBLE:
+         pos = addClosed(scan, 0, 0, "\"\"\"", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_TRIPLE_DOUBLE;
+         }
+
+         break;
+
+      case STATE_TEMPLATE:
+         pos = addClosed(scan, 0, 0, "`", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_TEMPLATE;
+         }
+
+         break;
+
+      case STATE_RAW:
+         pos = scan.findRaw(0, prevState >> 8);
+
+         if (pos < 0) {
+            scan.addRun(0, scan.m_size, TOKEN_QUOTE);
+            return prevState;
+         }
+
+         scan.addRun(0, pos, TOKEN_QUOTE);
+         break;
+
+      default:
+         break;
+   }
+
+   while (true) {
+      pos = scan.skipTo(pos, stop);
+
+      if (pos >= scan.m_size) {
+         return STATE_NORMAL;
+      }
+
+      unsigned char c = scan.m_data[pos];
+
+      if (c == '/') {
+         unsigned char next = scan.at(pos + 1);
+
+         if (next == '/') {
+            scan.addRun(pos, scan.m_size, TOKEN_COMMENT);
+            return STATE_NORMAL;
+
+         } else if (next == '*') {
+            pos = addClosed(scan, pos, pos + 2, "*/", false, TOKEN_MLINE);
+
+            if (pos < 0) {
+               return STATE_COMMENT;
+            }
+
+         } else if (type == LEXER_JS && scan.isRegexStart(pos)) {
+            // quotes inside a regex literal do not open a string, the literal itself is not colored
+            int end = scan.findRegex(pos);
+            pos = (end < 0) ? pos + 1 : end;
+
+         } else {
+            ++pos;
+
+         }
+
+      } else if (c == '"') {
+         int prefix = (type == LEXER_C) ? scan.rawPrefix(pos) : 0;
+
+         if (prefix > 0) {
+            int open = pos + 1;
+
+            while (open < scan.m_size && open - pos <= MAX_RAW_DELIMITER && scan.isRawDelimiter(scan.m_data[open])) {
+               ++open;
+            }
+
+            if (scan.at(open) == '(') {
+               int delimiterHash = scan.rawHash(pos + 1, open);
+               int end = scan.findRaw(open + 1, delimiterHash);
+
+               if (end < 0) {
+                  scan.addRun(pos - prefix, scan.m_size, TOKEN_QUOTE);
+                  return STATE_RAW | (delimiterHash << 8);
+               }
+
+               scan.addRun(pos - prefix, end, TOKEN_QUOTE);
+               pos = end;
+
+               continue;
+            }
+         }
+
+         if (type == LEXER_JAVA && scan.startsWith(pos, "\"\"\"")) {
+            // text block
+            pos = addClosed(scan, pos, pos + 3, "\"\"\"", true, TOKEN_QUOTE);
+
+            if (pos < 0) {
+               return STATE_TRIPLE_DOUBLE;
+            }
+
+            continue;
+         }
+
+         pos = addClosed(scan, pos, pos + 1, "\"", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return (type == LEXER_C && scan.isContinued()) ? STATE_STRING : STATE_NORMAL;
+         }
+
+      } else if (c == '\'') {
+
+         if (type == LEXER_C && scan.isDigitSeparator(pos)) {
+            ++pos;
+            continue;
+         }
+
+         pos = addClosed(scan, pos, pos + 1, "'", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_NORMAL;
+         }
+
+      } else if (c == '`') {
+         pos = addClosed(scan, pos, pos + 1, "`", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_TEMPLATE;
+         }
+
+      } else {
+         ++pos;
+
+      }
+   }
+}
+
+static int tokenizePython(LexScanner &scan, int prevState)
+{
+   int pos = 0;
+
+   if (prevState == STATE_TRIPLE_DOUBLE || prevState == STATE_TRIPLE_SINGLE) {
+      const char *close = (prevState == STATE_TRIPLE_DOUBLE) ? "\"\"\"" : "'''";
+
+      pos = addClosed(scan, 0, 0, close, true, TOKEN_QUOTE);
+
+      if (pos < 0) {
+         return prevState;
+      }
+   }
+
+   while (true) {
+      pos = scan.skipTo(pos, PYTHON_STOP);
+
+      if (pos >= scan.m_size) {
+         return STATE_NORMAL;
+      }
+
+      unsigned char c = scan.m_data[pos];
+
+      if (c == '#') {
+         scan.addRun(pos, scan.m_size, TOKEN_COMMENT);
+         return STATE_NORMAL;
+      }
+
+      if (scan.at(pos + 1) == c && scan.at(pos + 2) == c) {
+         // triple quoted string or docstring
+         const char *close = (c == '"') ? "\"\"\"" : "'''";
+
+         pos = addClosed(scan, pos, pos + 3, close, true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return (c == '"') ? STATE_TRIPLE_DOUBLE : STATE_TRIPLE_SINGLE;
+         }
+
+      } else {
+         // also for raw strings, r"\"" is a valid literal and r"\" is not closed, a backslash
+         // still keeps the quote after it from closing the string
+         pos = addClosed(scan, pos, pos + 1, (c == '"') ? "\"" : "'", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_NORMAL;
+         }
+      }
+   }
+}
+
+static int tokenizeShell(LexScanner &scan, int prevState)
+{
+   int pos = 0;
+
+   if (prevState == STATE_SHELL_SINGLE) {
+      pos = addClosed(scan, 0, 0, "'", false, TOKEN_QUOTE);
+
+      if (pos < 0) {
+         return STATE_SHELL_SINGLE;
+      }
+
+   } else if (prevState == STATE_SHELL_DOUBLE) {
+      pos = addClosed(scan, 0, 0, "\"", true, TOKEN_QUOTE);
+
+      if (pos < 0) {
+         return STATE_SHELL_DOUBLE;
+      }
+   }
+
+   while (true) {
+      pos = scan.skipTo(pos, SHELL_STOP);
+
+      if (pos >= scan.m_size) {
+         return STATE_NORMAL;
+      }
+
+      unsigned char c = scan.m_data[pos];
+
+      if (c == '\\') {
+         pos += 2;
+
+      } else if (c == '#') {
+         // only a comment at the start of a word, $# and ${#var} are not
+         if (pos == 0 || SHELL_BREAK[scan.m_data[pos - 1]]) {
+            scan.addRun(pos, scan.m_size, TOKEN_COMMENT);
+            return STATE_NORMAL;
+         }
+
+         ++pos;
+
+      } else if (c == '\'') {
+         pos = addClosed(scan, pos, pos + 1, "'", false, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_SHELL_SINGLE;
+         }
+
+      } else {
+         pos = addClosed(scan, pos, pos + 1, "\"", true, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_SHELL_DOUBLE;
+         }
+      }
+   }
+}
+
+static int tokenizeXml(LexScanner &scan, int prevState)
+{
+   int pos    = 0;
+   bool isTag = false;
+
+   if (prevState == STATE_COMMENT) {
+      pos = addClosed(scan, 0, 0, "-->", false, TOKEN_MLINE);
+
+      if (pos < 0) {
+         return STATE_COMMENT;
+      }
+
+   } else if (prevState == STATE_CDATA) {
+      pos = addClosed(scan, 0, 0, "]]>", false, TOKEN_QUOTE);
+
+      if (pos < 0) {
+         return STATE_CDATA;
+      }
+
+   } else if (prevState == STATE_TAG) {
+      isTag = true;
+
+   }
+
+   while (true) {
+
+      if (! isTag) {
+         pos = scan.skipTo(pos, XML_TEXT_STOP);
+
+         if (pos >= scan.m_size) {
+            return STATE_NORMAL;
+         }
+
+         if (scan.startsWith(pos, "<!--")) {
+            pos = addClosed(scan, pos, pos + 4, "-->", false, TOKEN_MLINE);
+
+            if (pos < 0) {
+               return STATE_COMMENT;
+            }
+
+         } else if (scan.startsWith(pos, "<![CDATA[")) {
+            pos = addClosed(scan, pos, pos + 9, "]]>", false, TOKEN_QUOTE);
+
+            if (pos < 0) {
+               return STATE_CDATA;
+            }
+
+         } else {
+            isTag = true;
+            ++pos;
+
+         }
+
+         continue;
+      }
+
+      // quotes are attribute values only inside a tag
+      pos = scan.skipTo(pos, XML_TAG_STOP);
+
+      if (pos >= scan.m_size) {
+         return STATE_TAG;
+      }
+
+      unsigned char c = scan.m_data[pos];
+
+      if (c == '>') {
+         isTag = false;
+         ++pos;
+
+      } else {
+         pos = addClosed(scan, pos, pos + 1, (c == '"') ? "\"" : "'", false, TOKEN_QUOTE);
+
+         if (pos < 0) {
+            return STATE_TAG;
+         }
+      }
+   }
+}
+
+SyntaxLexerType SyntaxLexer::lexerType(SyntaxTypes type)
+{
+   switch (type) {
+      case SYN_C:
+         return LEXER_C;
+
+      case SYN_JAVA:
+         return LEXER_JAVA;
+
+      case SYN_JS:
+         return LEXER_JS;
+
+      case SYN_JSON:
+         return LEXER_JSON;
+
+      case SYN_PYTHON:
+         return LEXER_PYTHON;
+
+      case SYN_SHELL:
+         return LEXER_SHELL;
+
+      case SYN_XML:
+         return LEXER_XML;
+
+      default:
+         return LEXER_NONE;
+   }
+}
+
+int SyntaxLexer::tokenize(SyntaxLexerType type, const QString &text, int prevState, QVector<SyntaxRun> &runList)
+{
+   LexScanner scan(text, runList);
+
+   if (prevState < 0) {
+      // first block of the document
+      prevState = STATE_NORMAL;
+   }
+
+   switch (type) {
+      case LEXER_C:
+      case LEXER_JAVA:
+      case LEXER_JS:
+      case LEXER_JSON:
+         return tokenizeC(scan, prevState, type);
+
+      case LEXER_PYTHON:
+         return tokenizePython(scan, prevState);
+
+      case LEXER_SHELL:
+         return tokenizeShell(scan, prevState);
+
+      case LEXER_XML:
+         return tokenizeXml(scan, prevState);
+
+      default:
+         return STATE_NORMAL;
+   }
+}
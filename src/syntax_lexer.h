@@ -0,0 +1,46 @@
+/**************************************************************************
+*
+* Copyright (c) 2012-2020 Barbara Geller
+*
+* Diamond Editor is free software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License version 2
+* as published by the Free Software Foundation.
+*
+* Diamond is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*
+***************************************************************************/
+
+#ifndef SYNTAX_LEXER_H
+#define SYNTAX_LEXER_H
+
+#include "settings.h"
+
+#include <QString>
+#include <QVector>
+
+enum SyntaxToken { TOKEN_KEY, TOKEN_CLASS, TOKEN_FUNC, TOKEN_TYPE, TOKEN_QUOTE, TOKEN_COMMENT, TOKEN_MLINE,
+                   TOKEN_SPELL, TOKEN_COUNT };
+
+struct SyntaxRun
+{
+   int start;
+   int length;
+   SyntaxToken token;
+};
+
+enum SyntaxLexerType { LEXER_NONE, LEXER_C, LEXER_JAVA, LEXER_JS, LEXER_JSON, LEXER_PYTHON, LEXER_SHELL,
+                       LEXER_XML };
+
+// hand written scanners for quotes and comments, keywords still come from the syntax file
+class SyntaxLexer
+{
+   public:
+      static SyntaxLexerType lexerType(SyntaxTypes type);
+
+      // appends quote and comment runs in text order, returns the block state
+      static int tokenize(SyntaxLexerType type, const QString &text, int prevState, QVector<SyntaxRun> &runList);
+};
+
+#endif